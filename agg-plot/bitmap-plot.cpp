@@ -12,11 +12,13 @@ extern "C" {
 #include "colors.h"
 #include "agg-pixfmt-config.h"
 #include "platform_support_ext.h"
+#include "profiler.h"
 
 void
 bitmap_save_image_cpp (sg_plot *p, const char *fn, unsigned w, unsigned h,
                        gslshell::ret_status& st)
 {
+    profiler_zone_scope zone(PROFILER_ZONE_AGG);
     agg::rendering_buffer rbuf_tmp;
     unsigned row_size = w * (gslshell::bpp / 8);
     unsigned buf_size = h * row_size;
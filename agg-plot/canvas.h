@@ -4,9 +4,11 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <limits.h>
+#include <math.h>
 
 #include "pixel_fmt.h"
 #include "sg_object.h"
+#include "glyph_cache.h"
 
 #include "agg_basics.h"
 #include "agg_rendering_buffer.h"
@@ -20,6 +22,8 @@ template <class Pixel>
 class renderer_gray_aa
 {
 public:
+    enum { subpixel_scale = 1 };
+
     renderer_gray_aa(agg::rendering_buffer& ren_buf, agg::rgba8 bg_color):
         m_pixbuf(ren_buf), m_ren_base(m_pixbuf), m_ren_solid(m_ren_base),
         m_bgcol(bg_color)
@@ -82,8 +86,10 @@ private:
 template <class Pixel>
 class renderer_subpixel_aa
 {
+public:
     enum { subpixel_scale = 3 };
 
+private:
     struct subpixel_scale_trans
     {
         void transform(double* x, double* y) const {
@@ -188,12 +194,38 @@ public:
         this->color(c);
         this->render_scanlines(this->ras, this->sl);
     }
+
+    // Draw a line of text using the cached coverage of each glyph. The
+    // baseline origin (x, y) is rounded vertically to the pixel grid.
+    bool draw_text(const text_layout& layout, double x, double y, agg::rgba8 c)
+    {
+        const unsigned xscale = Renderer::subpixel_scale;
+        const int iy = int(round(y));
+        glyph_raster_cache& cache = gslshell::glyph_cache();
+        glyph_coverage scratch;
+
+        for (unsigned k = 0; k < layout.size(); k++)
+        {
+            const double gx = (x + layout[k].x) * xscale;
+            const int ix = int(floor(gx));
+            const unsigned offset = unsigned((gx - ix) * glyph_raster_cache::subpixel_steps);
+            const glyph_coverage* cov = cache.coverage(layout[k].code, layout.height(), layout.width(), offset, xscale, scratch);
+            if (cov)
+                cov->render(this->renderer_base(), ix, iy, c);
+        }
+        return true;
+    }
 };
 
 struct virtual_canvas {
     virtual void draw(sg_object& vs, agg::rgba8 c) = 0;
     virtual void draw_outline(sg_object& vs, agg::rgba8 c) = 0;
 
+    // return false if the canvas cannot draw text from its layout
+    virtual bool draw_text(const text_layout& layout, double x, double y, agg::rgba8 c) {
+        return false;
+    }
+
     virtual void clip_box(const agg::rect_base<int>& clip) = 0;
     virtual void reset_clipping() = 0;
 
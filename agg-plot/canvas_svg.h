@@ -10,6 +10,7 @@
 #include "strpp.h"
 #include "sg_object.h"
 #include "draw_svg.h"
+#include "glyph_cache.h"
 
 static const char *svg_header =                                                \
         "<?xml version=\"1.0\" standalone=\"no\"?>\n"                                \
@@ -25,8 +26,8 @@ static const char *svg_end = "</svg>\n";
 
 class canvas_svg {
 public:
-    canvas_svg(FILE *f, double height):
-        m_output(f), m_height(height), m_current_id(0)  { }
+    canvas_svg(FILE *f, double height, const svg_stream::options& opt = svg_stream::options()):
+        m_output(f, opt), m_height(height), m_current_id(0)  { }
 
     void clip_box(const agg::rect_base<int>& clip) { }
 
@@ -35,48 +36,48 @@ public:
     template <class VertexSource>
     void draw(VertexSource& vs, agg::rgba8 c)
     {
-        str path;
-        svg_coords_from_vs(&vs, path, m_height);
-        str s = svg_fill_path(path, m_current_id++, c);
-        writeln(m_output, s, "   ");
+        m_output.write("   ");
+        svg_begin_path(m_output);
+        svg_coords_from_vs(&vs, m_output, m_height);
+        svg_end_fill_path(m_output, m_current_id++, c);
+        m_output.put('\n');
     }
 
     template <class VertexSource>
     void draw_outline(VertexSource& vs, agg::rgba8 c)
     {
-        str path;
-        svg_coords_from_vs(&vs, path, m_height);
-        str s = svg_stroke_path(path, default_stroke_width, m_current_id++, c);
-        writeln(m_output, s, "   ");
+        m_output.write("   ");
+        svg_begin_path(m_output);
+        svg_coords_from_vs(&vs, m_output, m_height);
+        svg_end_stroke_path(m_output, default_stroke_width, m_current_id++, c);
+        m_output.put('\n');
+    }
+
+    // the text is written using its outline, not the rasterized glyphs
+    bool draw_text(const text_layout& layout, double x, double y, agg::rgba8 c) {
+        return false;
     }
 
     void write_header(double w, double h) {
-        fprintf(m_output, svg_header, w, h);
+        m_output.printf(svg_header, w, h);
     }
     void write_end() {
-        fputs(svg_end, m_output);
+        m_output.write(svg_end);
+        m_output.flush();
     }
 
     void write_group_header(const char* id) {
-        fprintf(m_output, "<g id=\"%s\">\n", id);
+        m_output.printf("<g id=\"%s\">\n", id);
     }
 
     void write_group_end(const char* id) {
-        fprintf(m_output, "</g>\n");
-    }
-
-    static void writeln(FILE* f, str& s, const char* indent = 0) {
-        if (str_is_null(&s))
-            return;
-        if (indent)
-            fputs(indent, f);
-        fprintf(f, "%s\n", s.cstr());
+        m_output.write("</g>\n");
     }
 
     static const double default_stroke_width;
 
 private:
-    FILE *m_output;
+    svg_stream m_output;
     double m_height;
     int m_current_id;
 };
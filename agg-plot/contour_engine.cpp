@@ -0,0 +1,380 @@
+/* contour_engine.cpp
+ *
+ * Copyright (C) 2013 Francesco Abbate
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "agg_array.h"
+
+#include "contour_engine.h"
+
+typedef unsigned long long node_key;
+
+static inline bool is_finite(double z)
+{
+    return z - z == 0.0;
+}
+
+void contour_engine::add_vertex(agg::path_storage& ps, double x, double y, bool first) const
+{
+    if (m_polar > 0)
+    {
+        double r = fabs(x) > fabs(y) ? fabs(x) : fabs(y);
+        double th = atan2(y, x);
+        x = m_polar * r * cos(th);
+        y = m_polar * r * sin(th);
+    }
+    if (first)
+        ps.move_to(x, y);
+    else
+        ps.line_to(x, y);
+}
+
+// store the corners of the cell (i, j) in counter-clockwise order
+// followed by the center. Return false if a corner is not finite.
+bool contour_engine::cell_corners(unsigned i, unsigned j, vertex c[]) const
+{
+    c[0] = node(i, j);
+    c[1] = node(i, j + 1);
+    c[2] = node(i + 1, j + 1);
+    c[3] = node(i + 1, j);
+    for (int k = 0; k < 4; k++)
+    {
+        if (!is_finite(c[k].z))
+            return false;
+    }
+    c[4].x = c[0].x + m_dx / 2;
+    c[4].y = c[0].y + m_dy / 2;
+    c[4].z = (c[0].z + c[1].z + c[2].z + c[3].z) / 4;
+    return true;
+}
+
+// Sutherland-Hodgman clipping of a convex polygon against the
+// half-space sign * (z - t) >= 0
+template <class Vertex>
+static unsigned clip_level(const Vertex in[], unsigned n, double t, double sign, Vertex out[])
+{
+    unsigned m = 0;
+    for (unsigned k = 0; k < n; k++)
+    {
+        const Vertex& a = in[k];
+        const Vertex& b = in[k + 1 < n ? k + 1 : 0];
+        bool a_in = (sign * (a.z - t) >= 0), b_in = (sign * (b.z - t) >= 0);
+        if (a_in)
+            out[m++] = a;
+        if (a_in != b_in)
+        {
+            double f = (t - a.z) / (b.z - a.z);
+            Vertex& p = out[m++];
+            p.x = a.x + f * (b.x - a.x);
+            p.y = a.y + f * (b.y - a.y);
+            p.z = t;
+        }
+    }
+    return m;
+}
+
+void contour_engine::cell_band(const vertex c[], double lo, double hi, agg::path_storage& ps) const
+{
+    for (int k = 0; k < 4; k++)
+    {
+        vertex tri[3] = {c[k], c[(k + 1) % 4], c[4]};
+        vertex p1[8], p2[8];
+        unsigned n = clip_level(tri, 3, lo, 1.0, p1);
+        n = clip_level(p1, n, hi, -1.0, p2);
+        if (n < 3) continue;
+        for (unsigned q = 0; q < n; q++)
+            add_vertex(ps, p2[q].x, p2[q].y, q == 0);
+        ps.close_polygon();
+    }
+}
+
+// add the rectangle covering the cells from j1 to j2 (excluded) of
+// the row i. With the polar mapping every node along the horizontal
+// sides is added so that the sides follow the curved grid lines.
+void contour_engine::add_run(unsigned i, unsigned j1, unsigned j2, agg::path_storage& ps) const
+{
+    const unsigned step = (m_polar > 0 ? 1 : j2 - j1);
+    const double ya = m_y1 + i * m_dy, yb = ya + m_dy;
+    for (unsigned j = j1; j <= j2; j += step)
+        add_vertex(ps, m_x1 + j * m_dx, ya, j == j1);
+    for (unsigned j = j2 + step; j > j1; j -= step)
+        add_vertex(ps, m_x1 + (j - step) * m_dx, yb, false);
+    ps.close_polygon();
+}
+
+void contour_engine::band(double lo, double hi, agg::path_storage& ps) const
+{
+    vertex c[5];
+    for (unsigned i = 0; i < m_ny; i++)
+    {
+        // consecutive cells entirely inside the band are merged in a
+        // single rectangle
+        unsigned run_start = 0;
+        bool in_run = false;
+        for (unsigned j = 0; j < m_nx; j++)
+        {
+            bool inside = false;
+            if (cell_corners(i, j, c))
+            {
+                double zmin = c[0].z, zmax = c[0].z;
+                for (int k = 1; k < 4; k++)
+                {
+                    if (c[k].z < zmin) zmin = c[k].z;
+                    if (c[k].z > zmax) zmax = c[k].z;
+                }
+                if (zmin >= lo && zmax <= hi)
+                {
+                    inside = true;
+                }
+                else if (zmax >= lo && zmin <= hi)
+                {
+                    cell_band(c, lo, hi, ps);
+                }
+            }
+
+            if (inside && !in_run)
+            {
+                run_start = j;
+                in_run = true;
+            }
+            else if (!inside && in_run)
+            {
+                add_run(i, run_start, j, ps);
+                in_run = false;
+            }
+        }
+        if (in_run)
+            add_run(i, run_start, m_nx, ps);
+    }
+}
+
+namespace {
+
+// a segment of an iso-line. Each end lies on an edge of the
+// triangulation identified by the key of its two nodes.
+struct iso_segment {
+    node_key key[2];
+    double x[2], y[2];
+};
+
+struct key_entry {
+    node_key key;
+    unsigned end; // index of the segment times two plus the end
+};
+
+int key_entry_cmp(const void* pa, const void* pb)
+{
+    const key_entry* a = (const key_entry*) pa;
+    const key_entry* b = (const key_entry*) pb;
+    if (a->key != b->key)
+        return a->key < b->key ? -1 : 1;
+    return a->end < b->end ? -1 : (a->end > b->end ? 1 : 0);
+}
+
+}
+
+void contour_engine::isoline(double level, agg::path_storage& ps) const
+{
+    const node_key n_nodes = node_key(m_nx + 1) * (m_ny + 1);
+    const node_key n_total = n_nodes + node_key(m_nx) * m_ny;
+
+    agg::pod_bvector<iso_segment> segs;
+    vertex c[5];
+    node_key id[5];
+
+    for (unsigned i = 0; i < m_ny; i++)
+    {
+        for (unsigned j = 0; j < m_nx; j++)
+        {
+            if (!cell_corners(i, j, c))
+                continue;
+
+            // a node is "above" if z >= level. If all the corners are on
+            // the same side so is the center and the cell is skipped.
+            int n_above = 0;
+            for (int k = 0; k < 4; k++)
+                n_above += (c[k].z >= level);
+            if (n_above == 0 || n_above == 4)
+                continue;
+
+            id[0] = node_key(i) * (m_nx + 1) + j;
+            id[1] = id[0] + 1;
+            id[3] = id[0] + (m_nx + 1);
+            id[2] = id[3] + 1;
+            id[4] = n_nodes + node_key(i) * m_nx + j;
+
+            for (int k = 0; k < 4; k++)
+            {
+                const int tri[3] = {k, (k + 1) % 4, 4};
+                iso_segment s;
+                int ns = 0;
+                for (int e = 0; e < 3; e++)
+                {
+                    const vertex& a = c[tri[e]];
+                    const vertex& b = c[tri[(e + 1) % 3]];
+                    if ((a.z >= level) == (b.z >= level))
+                        continue;
+                    double f = (level - a.z) / (b.z - a.z);
+                    node_key ka = id[tri[e]], kb = id[tri[(e + 1) % 3]];
+                    s.key[ns] = (ka < kb ? ka * n_total + kb : kb * n_total + ka);
+                    s.x[ns] = a.x + f * (b.x - a.x);
+                    s.y[ns] = a.y + f * (b.y - a.y);
+                    ns++;
+                }
+                if (ns == 2)
+                    segs.add(s);
+            }
+        }
+    }
+
+    const unsigned n = segs.size();
+    if (n == 0)
+        return;
+
+    // an edge is shared by at most two triangles so each key appears
+    // at most twice. Sorting the keys gives the links between the
+    // ends of the segments.
+    agg::pod_array<key_entry> entries(2 * n);
+    for (unsigned k = 0; k < 2 * n; k++)
+    {
+        entries[k].key = segs[k / 2].key[k % 2];
+        entries[k].end = k;
+    }
+    qsort(&entries[0], 2 * n, sizeof(key_entry), key_entry_cmp);
+
+    agg::pod_array<int> link(2 * n);
+    for (unsigned k = 0; k < 2 * n; k++)
+        link[k] = -1;
+    for (unsigned k = 0; k + 1 < 2 * n; k++)
+    {
+        if (entries[k].key == entries[k + 1].key)
+        {
+            link[entries[k].end] = entries[k + 1].end;
+            link[entries[k + 1].end] = entries[k].end;
+            k++;
+        }
+    }
+
+    agg::pod_array<char> visited(n);
+    for (unsigned k = 0; k < n; k++)
+        visited[k] = 0;
+
+    // open polylines are traced first starting from their free ends,
+    // the segments left are part of closed loops
+    for (int pass = 0; pass < 2; pass++)
+    {
+        for (unsigned k = 0; k < 2 * n; k++)
+        {
+            unsigned sk = k / 2;
+            if (visited[sk] || (pass == 0 && link[k] >= 0))
+                continue;
+            unsigned end = k;
+            add_vertex(ps, segs[sk].x[end % 2], segs[sk].y[end % 2], true);
+            while (true)
+            {
+                unsigned sc = end / 2, other = end ^ 1;
+                visited[sc] = 1;
+                add_vertex(ps, segs[sc].x[other % 2], segs[sc].y[other % 2], false);
+                int next = link[other];
+                if (next < 0 || visited[next / 2])
+                    break;
+                end = next;
+            }
+            if (pass == 1)
+                ps.close_polygon();
+        }
+    }
+}
+
+namespace {
+
+struct contour_job {
+    const contour_engine* engine;
+    const double* levels;
+    unsigned nlevels;
+    agg::path_storage** bands;
+    agg::path_storage** lines;
+    unsigned next, count;
+    pthread_mutex_t mutex;
+};
+
+// the bands are the tasks from 0 to nlevels-2, the iso-lines follow
+void contour_task(const contour_job* job, unsigned k)
+{
+    const unsigned nbands = job->nlevels - 1;
+    if (k < nbands)
+        job->engine->band(job->levels[k], job->levels[k + 1], *job->bands[k]);
+    else
+        job->engine->isoline(job->levels[k - nbands], *job->lines[k - nbands]);
+}
+
+void* contour_worker(void* data)
+{
+    contour_job* job = (contour_job*) data;
+    while (true)
+    {
+        pthread_mutex_lock(&job->mutex);
+        unsigned k = job->next++;
+        pthread_mutex_unlock(&job->mutex);
+        if (k >= job->count)
+            break;
+        contour_task(job, k);
+    }
+    return NULL;
+}
+
+}
+
+void contour_engine::run(const double* levels, unsigned nlevels,
+                         agg::path_storage** bands, agg::path_storage** lines,
+                         unsigned nthreads) const
+{
+    if (nlevels < 2)
+        return;
+
+    contour_job job;
+    job.engine = this;
+    job.levels = levels;
+    job.nlevels = nlevels;
+    job.bands = bands;
+    job.lines = lines;
+    job.next = 0;
+    job.count = (nlevels - 1) + (lines ? nlevels : 0);
+    pthread_mutex_init(&job.mutex, NULL);
+
+    if (nthreads > job.count)
+        nthreads = job.count;
+
+    // the calling thread works as well so nthreads-1 are created
+    agg::pod_array<pthread_t> threads(nthreads > 1 ? nthreads - 1 : 1);
+    unsigned started = 0;
+    for (unsigned k = 0; k + 1 < nthreads; k++)
+    {
+        if (pthread_create(&threads[k], NULL, contour_worker, (void*) &job) != 0)
+            break;
+        started++;
+    }
+    contour_worker((void*) &job);
+    for (unsigned k = 0; k < started; k++)
+        pthread_join(threads[k], NULL);
+
+    pthread_mutex_destroy(&job.mutex);
+}
@@ -0,0 +1,81 @@
+/* contour_engine.h
+ *
+ * Copyright (C) 2013 Francesco Abbate
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef AGGPLOT_CONTOUR_ENGINE_H
+#define AGGPLOT_CONTOUR_ENGINE_H
+
+#include "agg_path_storage.h"
+
+// Marching squares over a grid of sampled values. The grid has
+// (ny+1) rows of (nx+1) values, the row i and column j correspond
+// to the point (x1 + j*dx, y1 + i*dy). Each cell is split in four
+// triangles around its center, whose value is the mean of the
+// corners, and the linear interpolation over the triangles gives
+// the iso-lines and the filled bands. The center value resolves the
+// saddle cells and the result is the same for neighbouring cells.
+// Cells with a non finite corner are left empty.
+class contour_engine {
+public:
+    contour_engine(const double* z, unsigned nx, unsigned ny, unsigned stride,
+                   double x1, double y1, double x2, double y2):
+        m_z(z), m_nx(nx), m_ny(ny), m_stride(stride),
+        m_x1(x1), m_y1(y1), m_dx((x2 - x1) / nx), m_dy((y2 - y1) / ny),
+        m_polar(0)
+    { }
+
+    // map the grid over the disk of radius R: the square [-1,1]x[-1,1]
+    // is mapped so that its concentric squares become circles
+    void set_polar(double R) { m_polar = R; }
+
+    // add the polygons of the region where lo <= z <= hi
+    void band(double lo, double hi, agg::path_storage& ps) const;
+
+    // add the polylines where z = level
+    void isoline(double level, agg::path_storage& ps) const;
+
+    // compute the bands between consecutive levels and, if "lines" is
+    // not NULL, the iso-lines of each level. The levels are
+    // distributed among "nthreads" threads.
+    void run(const double* levels, unsigned nlevels,
+             agg::path_storage** bands, agg::path_storage** lines,
+             unsigned nthreads) const;
+
+private:
+    struct vertex { double x, y, z; };
+
+    double value(unsigned i, unsigned j) const { return m_z[i * m_stride + j]; }
+
+    vertex node(unsigned i, unsigned j) const
+    {
+        vertex v = {m_x1 + j * m_dx, m_y1 + i * m_dy, value(i, j)};
+        return v;
+    }
+
+    bool cell_corners(unsigned i, unsigned j, vertex c[]) const;
+    void cell_band(const vertex c[], double lo, double hi, agg::path_storage& ps) const;
+    void add_run(unsigned i, unsigned j1, unsigned j2, agg::path_storage& ps) const;
+    void add_vertex(agg::path_storage& ps, double x, double y, bool first) const;
+
+    const double* m_z;
+    unsigned m_nx, m_ny, m_stride;
+    double m_x1, m_y1, m_dx, m_dy;
+    double m_polar;
+};
+
+#endif
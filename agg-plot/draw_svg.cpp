@@ -9,64 +9,73 @@ void format_rgb(char rgbstr[], agg::rgba8 c)
     sprintf(rgbstr, "#%02X%02X%02X", (int)c.r, (int)c.g, (int)c.b);
 }
 
-static void append_properties(str& s, svg_property_list* properties)
+static void append_properties(svg_stream& s, svg_property_list* properties)
 {
     for (svg_property_list* p = properties; p; p = p->next())
     {
         svg_property_item& item = p->content();
         const char* name = svg_path_property_name[item.key];
-        s.printf_add(";%s:%s", name, item.value);
+        s.printf(";%s:%s", name, item.value);
     }
 }
 
-static void property_append_alpha(str& s, const char* prop, agg::rgba8 c)
+static void property_append_alpha(svg_stream& s, const char* prop, agg::rgba8 c)
 {
     if (c.a < 255) {
         double alpha = (double)c.a / 255;
-        s.printf_add(";%s:%g", prop, alpha);
+        s.printf(";%s:%g", prop, alpha);
     }
 }
 
-static str gen_path_element(str& content, str& style, int id)
+void svg_begin_path(svg_stream& s)
 {
-    str s = str::print("<path d=\"%s\" ", content.cstr());
+    s.write("<path d=\"");
+    s.path_begin();
+}
+
+static void end_path_data(svg_stream& s, int id)
+{
+    s.path_end();
+    s.write("\" ");
     if (id >= 0)
-        s.printf_add("id=\"path%i\" ", id);
-    s.printf_add("style=\"%s\" />", style.cstr());
-    return s;
+        s.printf("id=\"path%i\" ", id);
+    s.write("style=\"");
 }
 
-str svg_stroke_path(str& path_coords, double width, int id, agg::rgba8 c,
-                    svg_property_list* properties)
+void svg_end_stroke_path(svg_stream& s, double width, int id, agg::rgba8 c,
+                         svg_property_list* properties)
 {
     char rgbstr[8];
     format_rgb(rgbstr, c);
 
-    str s = str::print("fill:none;stroke:%s;"
-                       "stroke-width:%g;stroke-linecap:butt;"
-                       "stroke-linejoin:miter",
-                       rgbstr, width);
+    end_path_data(s, id);
+    s.printf("fill:none;stroke:%s;"
+             "stroke-width:%g;stroke-linecap:butt;"
+             "stroke-linejoin:miter",
+             rgbstr, width);
 
     property_append_alpha(s, "stroke-opacity", c);
     append_properties(s, properties);
-
-    return gen_path_element(path_coords, s, id);
+    s.write("\" />");
 }
 
-str svg_marker_path(str& path_coords, double sw, int id, svg_property_list* properties)
+void svg_end_marker_path(svg_stream& s, double sw, int id, svg_property_list* properties)
 {
-    str s = str::print("fill:none;stroke:none;stroke-width:%g", sw);
+    end_path_data(s, id);
+    s.printf("fill:none;stroke:none;stroke-width:%g", sw);
     append_properties(s, properties);
-    return gen_path_element(path_coords, s, id);
+    s.write("\" />");
 }
 
-str svg_fill_path(str& path_coords, int id, agg::rgba8 c,
-                  svg_property_list* properties)
+void svg_end_fill_path(svg_stream& s, int id, agg::rgba8 c,
+                       svg_property_list* properties)
 {
     char rgbstr[8];
     format_rgb(rgbstr, c);
-    str s = str::print("fill:%s;stroke:none", rgbstr);
+
+    end_path_data(s, id);
+    s.printf("fill:%s;stroke:none", rgbstr);
     property_append_alpha(s, "fill-opacity", c);
     append_properties(s, properties);
-    return gen_path_element(path_coords, s, id);
+    s.write("\" />");
 }
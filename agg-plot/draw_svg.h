@@ -5,6 +5,7 @@
 #include "agg_color_rgba.h"
 #include "list.h"
 #include "strpp.h"
+#include "svg_stream.h"
 
 enum svg_path_property_e {
     stroke_dasharray = 0,
@@ -38,75 +39,69 @@ vertex_flip(VertexSource* vs, double* x, double* y, double h)
 typedef list<svg_property_item> svg_property_list;
 
 template <typename VertexSource>
-void svg_coords_from_vs(VertexSource* vs, str& s, double h)
+void svg_coords_from_vs(VertexSource* vs, svg_stream& s, double h)
 {
     unsigned cmd;
     double x, y;
-    const char * const space = " ";
-    const char *sep = "";
 
     vs->rewind(0);
 
     while ((cmd = vertex_flip(vs, &x, &y, h)))
     {
         if (agg::is_move_to(cmd)) {
-            s.printf_add("%sM %g,%g", sep, x, y);
+            s.move_to(x, y);
         } else if (agg::is_line_to(cmd)) {
-            s.printf_add("%s%g,%g", sep, x, y);
+            s.line_to(x, y);
         }        else if (agg::is_close(cmd)) {
-            s.printf_add("%sz", sep);
+            s.close_path();
         }        else if (agg::is_curve3(cmd)) {
             vertex_flip(vs, &x, &y, h);
-            s.printf_add("%s%g,%g", sep, x, y);
+            s.line_to(x, y);
         }        else if (agg::is_curve4(cmd)) {
             vs->vertex(&x, &y);
             vertex_flip(vs, &x, &y, h);
-            s.printf_add("%s%g,%g", sep, x, y);
+            s.line_to(x, y);
         }
-        sep = space;
     }
 }
 
 template <typename VertexSource>
-void svg_curve_coords_from_vs(VertexSource* vs, str& s, double h)
+void svg_curve_coords_from_vs(VertexSource* vs, svg_stream& s, double h)
 {
     unsigned cmd;
     double x, y;
-    const char * const space = " ";
-    const char *sep = "";
-    bool omit_line_to = false;
 
     vs->rewind(0);
 
     while ((cmd = vertex_flip(vs, &x, &y, h)))
     {
         if (agg::is_move_to(cmd)) {
-            s.printf_add("%sM %g,%g", sep, x, y);
-            omit_line_to = true;
+            s.move_to(x, y);
         } else if (agg::is_line_to(cmd)) {
-            s.printf_add("%s%s%g,%g", sep, omit_line_to ? "" : "L ", x, y);
+            s.line_to(x, y);
         }        else if (agg::is_curve4(cmd)) {
             double x1 = x, y1 = y;
             double x2, y2;
             vertex_flip(vs, &x2, &y2, h);
             vertex_flip(vs, &x, &y, h);
-            s.printf_add("%sC %g,%g %g,%g %g,%g", sep, x1, y1, x2, y2, x, y);
-            omit_line_to = false;
+            s.curve4(x1, y1, x2, y2, x, y);
         }        else if (agg::is_curve3(cmd)) {
             double x1 = x, y1 = y;
             vertex_flip(vs, &x, &y, h);
-            s.printf_add("%sQ %g,%g %g,%g", sep, x1, y1, x, y);
-            omit_line_to = false;
+            s.curve3(x1, y1, x, y);
         }        else if (agg::is_close(cmd)) {
-            s.printf_add("%sz", sep);
+            s.close_path();
         }
-        sep = space;
     }
 }
 
-extern str svg_stroke_path(str& path_coords, double width, int id, agg::rgba8 c, svg_property_list* properties = 0);
-extern str svg_fill_path(str& path_coords, int id, agg::rgba8 c, svg_property_list* properties = 0);
-extern str svg_marker_path(str& path_coords, double sw, int id, svg_property_list* properties);
+// A path element is written with svg_begin_path followed by the path
+// coordinates and one of the svg_end_*_path functions that write the
+// style of the path.
+extern void svg_begin_path(svg_stream& s);
+extern void svg_end_stroke_path(svg_stream& s, double width, int id, agg::rgba8 c, svg_property_list* properties = 0);
+extern void svg_end_fill_path(svg_stream& s, int id, agg::rgba8 c, svg_property_list* properties = 0);
+extern void svg_end_marker_path(svg_stream& s, double sw, int id, svg_property_list* properties);
 extern void format_rgb(char rgbstr[], agg::rgba8 c);
 
 #endif
@@ -0,0 +1,234 @@
+/* glyph_cache.cpp
+ *
+ * Copyright (C) 2013 Francesco Abbate
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <pthread.h>
+#include <math.h>
+
+#include "agg_rasterizer_scanline_aa.h"
+#include "agg_scanline_u.h"
+#include "agg_conv_curve.h"
+#include "agg_conv_transform.h"
+
+#include "agg-pixfmt-config.h"
+#include "glyph_cache.h"
+
+typedef agg::font_engine_freetype_int32 font_engine_type;
+typedef agg::font_cache_manager<font_engine_type> font_manager_type;
+
+// protect the font engine and its outline cache, shared by all the
+// glyph layouts, rasterizations and text outlines. The mutex is
+// recursive since the text labels lock it around calls that lock it
+// again.
+static pthread_mutex_t font_mutex;
+static pthread_once_t font_mutex_once = PTHREAD_ONCE_INIT;
+
+static void font_mutex_init()
+{
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&font_mutex, &attr);
+    pthread_mutexattr_destroy(&attr);
+}
+
+void gslshell::font_lock()
+{
+    pthread_once(&font_mutex_once, font_mutex_init);
+    pthread_mutex_lock(&font_mutex);
+}
+
+void gslshell::font_unlock()
+{
+    pthread_mutex_unlock(&font_mutex);
+}
+
+static glyph_raster_cache global_glyph_cache;
+
+glyph_raster_cache& gslshell::glyph_cache()
+{
+    return global_glyph_cache;
+}
+
+static void set_font_size(font_engine_type& eng, double height, double width)
+{
+    if (eng.height() != height)
+        eng.height(height);
+    if (eng.width() != width * text_layout::scale_x)
+        eng.width(width * text_layout::scale_x);
+}
+
+void glyph_coverage::set(const agg::pod_bvector<span>& spans, const agg::pod_bvector<agg::int8u>& covers)
+{
+    m_spans.resize(spans.size());
+    for (unsigned k = 0; k < spans.size(); k++)
+        m_spans[k] = spans[k];
+    m_covers.resize(covers.size());
+    for (unsigned k = 0; k < covers.size(); k++)
+        m_covers[k] = covers[k];
+}
+
+void text_layout::update(const char* text, unsigned len, double height, double width)
+{
+    if (height == m_height && width == m_width)
+        return;
+
+    font_engine_type& eng = gslshell::font_engine();
+    font_manager_type& man = gslshell::font_manager();
+
+    gslshell::font_lock();
+    set_font_size(eng, height, width);
+    man.reset_last_glyph();
+
+    m_glyphs.clear();
+    double x = 0, y = 0;
+    for (unsigned k = 0; k < len; k++)
+    {
+        const unsigned code = (unsigned char) text[k];
+        const agg::glyph_cache* glyph = man.glyph(code);
+        if (!glyph)
+            continue;
+        man.add_kerning(&x, &y);
+        glyph_pos g;
+        g.code = code;
+        g.x = x / scale_x;
+        m_glyphs.add(g);
+        x += glyph->advance_x;
+    }
+    gslshell::font_unlock();
+
+    m_height = height;
+    m_width = width;
+    m_text_width = x / scale_x;
+}
+
+// Rasterize the glyph outline with the origin moved by "dx" along x.
+// The font lock should be taken.
+static bool rasterize_glyph(glyph_coverage& cov, unsigned code, double height, double width,
+                            double dx, unsigned xscale)
+{
+    font_engine_type& eng = gslshell::font_engine();
+    font_manager_type& man = gslshell::font_manager();
+
+    set_font_size(eng, height, width);
+    const agg::glyph_cache* glyph = man.glyph(code);
+    if (!glyph || glyph->data_type != agg::glyph_data_outline)
+        return false;
+    man.init_embedded_adaptors(glyph, 0, 0);
+
+    typedef agg::conv_curve<font_manager_type::path_adaptor_type> curve_type;
+    curve_type curve(man.path_adaptor());
+    agg::trans_affine mtx(double(xscale) / text_layout::scale_x, 0.0, 0.0, 1.0, dx, 0.0);
+    agg::conv_transform<curve_type> glyph_path(curve, mtx);
+
+    agg::rasterizer_scanline_aa<> ras;
+    agg::scanline_u8 sl;
+    ras.add_path(glyph_path);
+
+    agg::pod_bvector<glyph_coverage::span> spans;
+    agg::pod_bvector<agg::int8u> covers;
+    if (ras.rewind_scanlines())
+    {
+        sl.reset(ras.min_x(), ras.max_x());
+        while (ras.sweep_scanline(sl))
+        {
+            agg::scanline_u8::const_iterator sp = sl.begin();
+            for (unsigned n = sl.num_spans(); n > 0; n--, ++sp)
+            {
+                glyph_coverage::span s;
+                s.x = sp->x;
+                s.y = sl.y();
+                s.len = sp->len;
+                s.offset = covers.size();
+                for (int j = 0; j < sp->len; j++)
+                    covers.add(sp->covers[j]);
+                spans.add(s);
+            }
+        }
+    }
+
+    cov.set(spans, covers);
+    return true;
+}
+
+glyph_raster_cache::glyph_raster_cache(): m_buckets(buckets_number), m_count(0)
+{
+    for (unsigned k = 0; k < buckets_number; k++)
+        m_buckets[k] = 0;
+}
+
+glyph_raster_cache::~glyph_raster_cache()
+{
+    for (unsigned k = 0; k < buckets_number; k++)
+    {
+        entry* e = m_buckets[k];
+        while (e)
+        {
+            entry* next = e->next;
+            delete e;
+            e = next;
+        }
+    }
+}
+
+const glyph_coverage*
+glyph_raster_cache::coverage(unsigned code, double height, double width,
+                             unsigned offset, unsigned xscale,
+                             glyph_coverage& scratch)
+{
+    const int ih = int(height * 64), iw = int(width * 64);
+    const unsigned h = (code * 31 + ih * 17 + iw * 13 + offset * 7 + xscale) % buckets_number;
+
+    const glyph_coverage* result = 0;
+
+    gslshell::font_lock();
+    entry* e;
+    for (e = m_buckets[h]; e; e = e->next)
+    {
+        if (e->code == code && e->height == ih && e->width == iw &&
+            e->offset == offset && e->xscale == xscale)
+            break;
+    }
+
+    const double dx = double(offset) / subpixel_steps;
+    if (e)
+    {
+        result = (e->valid ? &e->cov : 0);
+    }
+    else if (m_count < max_glyphs)
+    {
+        e = new entry;
+        e->code = code;
+        e->height = ih;
+        e->width = iw;
+        e->offset = offset;
+        e->xscale = xscale;
+        e->valid = rasterize_glyph(e->cov, code, height, width, dx, xscale);
+        e->next = m_buckets[h];
+        m_buckets[h] = e;
+        m_count++;
+        result = (e->valid ? &e->cov : 0);
+    }
+    else if (rasterize_glyph(scratch, code, height, width, dx, xscale))
+    {
+        result = &scratch;
+    }
+    gslshell::font_unlock();
+
+    return result;
+}
@@ -0,0 +1,135 @@
+/* glyph_cache.h
+ *
+ * Copyright (C) 2013 Francesco Abbate
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef AGGPLOT_GLYPH_CACHE_H
+#define AGGPLOT_GLYPH_CACHE_H
+
+#include "agg_basics.h"
+#include "agg_array.h"
+#include "agg_color_rgba.h"
+
+// Coverage of a rasterized glyph stored as horizontal spans. The
+// coordinates are relative to the glyph origin and, in LCD mode, the
+// x coordinates are in subpixel units.
+class glyph_coverage {
+public:
+    struct span {
+        int x, y;
+        unsigned len, offset;
+    };
+
+    void set(const agg::pod_bvector<span>& spans, const agg::pod_bvector<agg::int8u>& covers);
+
+    template <class RendererBase>
+    void render(RendererBase& rb, int x, int y, agg::rgba8 c) const
+    {
+        for (unsigned k = 0; k < m_spans.size(); k++)
+        {
+            const span& s = m_spans[k];
+            rb.blend_solid_hspan(x + s.x, y + s.y, s.len, c, &m_covers[s.offset]);
+        }
+    }
+
+private:
+    agg::pod_array<span> m_spans;
+    agg::pod_array<agg::int8u> m_covers;
+};
+
+// Position of the glyphs of a line of text with the advance and the
+// kerning of the font at a given size. The layout is computed again
+// only when the size changes.
+class text_layout {
+public:
+    // the font engine works with a width scaled by this factor to get
+    // a precise horizontal positioning
+    enum { scale_x = 100 };
+
+    struct glyph_pos {
+        unsigned code;
+        double x;
+    };
+
+    text_layout(): m_height(-1), m_width(-1), m_text_width(0) { }
+
+    void update(const char* text, unsigned len, double height, double width);
+
+    unsigned size() const { return m_glyphs.size(); }
+    const glyph_pos& operator[](unsigned k) const { return m_glyphs[k]; }
+
+    double height() const { return m_height; }
+    double width() const { return m_width; }
+    double text_width() const { return m_text_width; }
+
+private:
+    agg::pod_bvector<glyph_pos> m_glyphs;
+    double m_height, m_width;
+    double m_text_width;
+};
+
+// Cache of the rasterized glyphs of the plot font keyed by code,
+// font size, horizontal subpixel offset and horizontal scale, equal
+// to three in LCD mode. The entries are never modified nor removed
+// once inserted so the cache can be used by several threads. When
+// the cache is full new glyphs are rasterized in a scratch coverage
+// given by the caller.
+class glyph_raster_cache {
+public:
+    enum { subpixel_steps = 4 };
+    enum { max_glyphs = 8192 };
+
+    glyph_raster_cache();
+    ~glyph_raster_cache();
+
+    // return NULL if the font has no such glyph
+    const glyph_coverage* coverage(unsigned code, double height, double width,
+                                   unsigned offset, unsigned xscale,
+                                   glyph_coverage& scratch);
+
+private:
+    enum { buckets_number = 1024 };
+
+    struct entry {
+        unsigned code, offset, xscale;
+        int height, width;
+        bool valid;
+        glyph_coverage cov;
+        entry* next;
+    };
+
+    agg::pod_array<entry*> m_buckets;
+    unsigned m_count;
+};
+
+namespace gslshell {
+extern glyph_raster_cache& glyph_cache();
+
+// Lock of the font engine and of its outline cache. It should be
+// taken by any code that uses them since the text can be measured by
+// the Lua thread while the windows are drawn. The lock is recursive.
+extern void font_lock();
+extern void font_unlock();
+}
+
+class font_lock_scope {
+public:
+    font_lock_scope() { gslshell::font_lock(); }
+    ~font_lock_scope() { gslshell::font_unlock(); }
+};
+
+#endif
@@ -0,0 +1,158 @@
+/* lua-contour.cpp
+ *
+ * Copyright (C) 2013 Francesco Abbate
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <stdint.h>
+
+extern "C" {
+#include "lua.h"
+#include "lauxlib.h"
+}
+
+#include "lua-contour.h"
+#include "lua-cpp-utils.h"
+#include "gs-types.h"
+#include "contour_engine.h"
+#include "path.h"
+#include "profiler.h"
+
+static int contour_paths (lua_State *L);
+
+/* push the field "key" of the options table or nil */
+static void
+opt_field (lua_State *L, int index, const char *key)
+{
+    if (lua_istable (L, index))
+        lua_getfield (L, index, key);
+    else
+        lua_pushnil (L);
+}
+
+/* contour_paths(data, n1, n2, tda, x1, y1, x2, y2, levels[, options])
+
+   The values are given as the address of the data of a n1 x n2
+   matrix with row stride "tda" whose rows and columns sample the
+   rectangle (x1, y1), (x2, y2) along y and x. The matrix is not
+   passed itself since its type cannot be checked here: the contour
+   module checks it is a gsl_matrix and passes its fields. Since the
+   address cannot be validated the function is not exported in the
+   graph module but stored in the registry for the contour module. Return a
+   table with the path of each band between consecutive levels and,
+   if options.lines is true, a table with the iso-line of each
+   level. */
+int
+contour_paths (lua_State *L)
+{
+    const double *data = (const double *) (uintptr_t) luaL_checknumber (L, 1);
+    int n1 = luaL_checkinteger (L, 2), n2 = luaL_checkinteger (L, 3);
+    int tda = luaL_checkinteger (L, 4);
+    double x1 = gs_check_number (L, 5, FP_CHECK_NORMAL);
+    double y1 = gs_check_number (L, 6, FP_CHECK_NORMAL);
+    double x2 = gs_check_number (L, 7, FP_CHECK_NORMAL);
+    double y2 = gs_check_number (L, 8, FP_CHECK_NORMAL);
+    luaL_checktype (L, 9, LUA_TTABLE);
+
+    if (data == 0)
+        return luaL_error (L, "invalid matrix data");
+    if (n1 < 2 || n2 < 2)
+        return luaL_error (L, "the matrix should have at least two rows and columns");
+    if (tda < n2)
+        return luaL_error (L, "invalid matrix row stride");
+
+    opt_field (L, 10, "lines");
+    bool want_lines = lua_toboolean (L, -1);
+    lua_pop (L, 1);
+
+    opt_field (L, 10, "threads");
+    int nthreads = (lua_isnumber (L, -1) ? lua_tointeger (L, -1) : 1);
+    lua_pop (L, 1);
+
+    opt_field (L, 10, "polar");
+    double polar = (lua_isnumber (L, -1) ? lua_tonumber (L, -1) : 0);
+    lua_pop (L, 1);
+
+    const int nlevels = lua_objlen (L, 9);
+    if (nlevels < 2)
+        return luaL_error (L, "at least two levels are required");
+
+    /* the arguments are checked before any allocation since
+       luaL_error does not return */
+    double z_prev = 0;
+    for (int k = 0; k < nlevels; k++)
+    {
+        lua_rawgeti (L, 9, k + 1);
+        if (!lua_isnumber (L, -1))
+            return luaL_error (L, "invalid level at index %d", k + 1);
+        double z = lua_tonumber (L, -1);
+        lua_pop (L, 1);
+        if (k > 0 && z < z_prev)
+            return luaL_error (L, "the levels should be in increasing order");
+        z_prev = z;
+    }
+
+    agg::pod_array<double> levels(nlevels);
+    for (int k = 0; k < nlevels; k++)
+    {
+        lua_rawgeti (L, 9, k + 1);
+        levels[k] = lua_tonumber (L, -1);
+        lua_pop (L, 1);
+    }
+
+    /* the paths are created before the computation so that they are
+       owned by the Lua state if an error is raised */
+    agg::pod_array<agg::path_storage*> bands(nlevels - 1);
+    agg::pod_array<agg::path_storage*> lines(nlevels);
+
+    lua_createtable (L, nlevels - 1, 0);
+    for (int k = 0; k < nlevels - 1; k++)
+    {
+        draw::path *p = push_new_object<draw::path>(L, GS_DRAW_PATH);
+        bands[k] = &p->self();
+        lua_rawseti (L, -2, k + 1);
+    }
+
+    if (want_lines)
+    {
+        lua_createtable (L, nlevels, 0);
+        for (int k = 0; k < nlevels; k++)
+        {
+            draw::path *p = push_new_object<draw::path>(L, GS_DRAW_PATH);
+            lines[k] = &p->self();
+            lua_rawseti (L, -2, k + 1);
+        }
+    }
+
+    contour_engine engine(data, n2 - 1, n1 - 1, tda, x1, y1, x2, y2);
+    if (polar > 0)
+        engine.set_polar(polar);
+
+    /* the new paths are not yet referenced by any plot so the
+       agg_mutex is not needed */
+    profiler_zone_scope zone(PROFILER_ZONE_AGG);
+    engine.run(&levels[0], nlevels, &bands[0], want_lines ? &lines[0] : 0,
+               nthreads > 1 ? nthreads : 1);
+
+    return (want_lines ? 2 : 1);
+}
+
+void
+contour_register (lua_State *L)
+{
+    lua_pushcfunction (L, contour_paths);
+    lua_setfield (L, LUA_REGISTRYINDEX, "__gsl_contour_paths");
+}
@@ -28,6 +28,8 @@ extern "C" {
 #include "window_registry.h"
 #include "lua-draw.h"
 #include "lua-text.h"
+#include "lua-contour.h"
+#include "lua-mesh3d.h"
 #include "window.h"
 #include "lua-plot.h"
 #include "window_hooks.h"
@@ -63,6 +65,8 @@ register_graph (lua_State *L)
 
     draw_register (L);
     text_register (L);
+    contour_register (L);
+    mesh3d_register (L);
     app_window_hooks->register_module (L);
     plot_register (L);
 
@@ -0,0 +1,201 @@
+/* lua-mesh3d.cpp
+ *
+ * Copyright (C) 2013 Francesco Abbate
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <pthread.h>
+#include <stdint.h>
+
+extern "C" {
+#include "lua.h"
+#include "lauxlib.h"
+}
+
+#include "lua-mesh3d.h"
+#include "lua-graph.h"
+#include "lua-cpp-utils.h"
+#include "gs-types.h"
+#include "colors.h"
+#include "mesh3d.h"
+
+static int mesh3d_new    (lua_State *L);
+static int mesh3d_free   (lua_State *L);
+static int mesh3d_camera (lua_State *L);
+static int mesh3d_faces  (lua_State *L);
+
+static const struct luaL_Reg mesh3d_methods[] = {
+    {"__gc",        mesh3d_free},
+    {"camera",      mesh3d_camera},
+    {"faces",       mesh3d_faces},
+    {NULL, NULL}
+};
+
+/* a matrix given as the address of its data, its dimensions and its
+   row stride */
+struct matrix_arg {
+    const double *data;
+    unsigned size1, size2, tda;
+};
+
+/* read the matrix given by the four arguments starting at "index" */
+static void
+check_matrix_arg (lua_State *L, int index, matrix_arg& m)
+{
+    m.data = (const double *) (uintptr_t) luaL_checknumber (L, index);
+    int n1 = luaL_checkinteger (L, index + 1), n2 = luaL_checkinteger (L, index + 2);
+    int tda = luaL_checkinteger (L, index + 3);
+    if (m.data == 0 || n1 < 0 || n2 < 0 || tda < n2)
+        luaL_error (L, "invalid matrix at argument #%d", index);
+    m.size1 = n1;
+    m.size2 = n2;
+    m.tda = tda;
+}
+
+static bool
+opt_boolean (lua_State *L, int index, const char *key, bool def)
+{
+    if (!lua_istable (L, index))
+        return def;
+    lua_getfield (L, index, key);
+    bool v = (lua_isnil (L, -1) ? def : lua_toboolean (L, -1));
+    lua_pop (L, 1);
+    return v;
+}
+
+static bool
+opt_color (lua_State *L, int index, const char *key, agg::rgba8& c)
+{
+    if (!lua_istable (L, index))
+        return false;
+    lua_getfield (L, index, key);
+    bool found = !lua_isnil (L, -1);
+    if (found)
+        c = color_arg_lookup (L, -1);
+    lua_pop (L, 1);
+    return found;
+}
+
+/* mesh3d_data(vdata, nv, vcols, vtda, fdata, nf, fcols, ftda[, options])
+
+   The vertices are the rows of a matrix with three columns. Each
+   row of the matrix "faces" gives the indexes, starting from 1, of
+   the vertices of a triangle or of a quadrilateral. With four
+   columns an index equal to zero in the last one gives a triangle.
+   The matrices are given by the address of their data, their
+   dimensions and their row stride. The function graph.mesh3d checks
+   that its arguments are real matrices and calls this function with
+   their fields. Since the addresses cannot be validated the function
+   is stored in the registry instead of the graph module. */
+int
+mesh3d_new (lua_State *L)
+{
+    matrix_arg v, f;
+    check_matrix_arg (L, 1, v);
+    check_matrix_arg (L, 5, f);
+
+    if (v.size2 != 3)
+        return luaL_error (L, "the vertices matrix should have three columns");
+    if (f.size2 != 3 && f.size2 != 4)
+        return luaL_error (L, "the faces matrix should have three or four columns");
+
+    const unsigned nv = v.size1, nf = f.size1;
+    for (unsigned k = 0; k < nf; k++)
+    {
+        for (unsigned j = 0; j < f.size2; j++)
+        {
+            double idx = f.data[k * f.tda + j];
+            bool last_zero = (j == 3 && idx == 0);
+            if (!last_zero && (idx < 1 || idx > nv || idx != (unsigned) idx))
+                return luaL_error (L, "invalid vertex index in face %d", k + 1);
+        }
+    }
+
+    draw::mesh3d::options opt;
+    opt.own_color = opt_color (L, 9, "color", opt.color);
+    opt.own_back_color = opt_color (L, 9, "backcolor", opt.back_color);
+    opt.stroke = opt_color (L, 9, "stroke", opt.stroke_color);
+    opt.light = opt_boolean (L, 9, "light", true);
+    opt.backfaces = opt_boolean (L, 9, "backfaces", true);
+    opt.overdraw = opt_boolean (L, 9, "overdraw", true);
+
+    draw::mesh3d *m = new(L, GS_DRAW_MESH3D) draw::mesh3d(nv, nf, opt);
+
+    for (unsigned k = 0; k < nv; k++)
+    {
+        const double *row = v.data + k * v.tda;
+        m->set_vertex(k, row[0], row[1], row[2]);
+    }
+
+    for (unsigned k = 0; k < nf; k++)
+    {
+        const double *row = f.data + k * f.tda;
+        unsigned i3 = draw::mesh3d::no_vertex;
+        if (f.size2 == 4 && row[3] != 0)
+            i3 = (unsigned) row[3] - 1;
+        m->set_face(k, (unsigned) row[0] - 1, (unsigned) row[1] - 1, (unsigned) row[2] - 1, i3);
+    }
+
+    return 1;
+}
+
+int
+mesh3d_free (lua_State *L)
+{
+    return object_free<draw::mesh3d>(L, 1, GS_DRAW_MESH3D);
+}
+
+/* mesh:camera(rx, ry[, distance[, focal]]) */
+int
+mesh3d_camera (lua_State *L)
+{
+    draw::mesh3d *m = object_check<draw::mesh3d>(L, 1, GS_DRAW_MESH3D);
+    double rx = luaL_checknumber (L, 2);
+    double ry = luaL_checknumber (L, 3);
+    double distance = luaL_optnumber (L, 4, 10.0);
+    double focal = luaL_optnumber (L, 5, 10.0);
+
+    /* the mesh can be drawn by a window thread */
+    pthread_mutex_lock (agg_mutex);
+    m->set_camera (rx, ry, distance, focal);
+    pthread_mutex_unlock (agg_mutex);
+    return 0;
+}
+
+/* return the number of faces visible from the camera */
+int
+mesh3d_faces (lua_State *L)
+{
+    draw::mesh3d *m = object_check<draw::mesh3d>(L, 1, GS_DRAW_MESH3D);
+    pthread_mutex_lock (agg_mutex);
+    unsigned n = m->visible_faces();
+    pthread_mutex_unlock (agg_mutex);
+    lua_pushinteger (L, n);
+    return 1;
+}
+
+void
+mesh3d_register (lua_State *L)
+{
+    luaL_newmetatable (L, GS_METATABLE(GS_DRAW_MESH3D));
+    lua_pushvalue (L, -1);
+    lua_setfield (L, -2, "__index");
+    luaL_register (L, NULL, mesh3d_methods);
+    lua_pop (L, 1);
+
+    lua_pushcfunction (L, mesh3d_new);
+    lua_setfield (L, LUA_REGISTRYINDEX, "__gsl_mesh3d_data");
+}
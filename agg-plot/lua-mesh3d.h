@@ -0,0 +1,14 @@
+#ifndef AGGPLOT_LUA_MESH3D_H
+#define AGGPLOT_LUA_MESH3D_H
+
+#include "defs.h"
+
+__BEGIN_DECLS
+
+#include <lua.h>
+
+extern void mesh3d_register (lua_State *L);
+
+__END_DECLS
+
+#endif
@@ -13,4 +13,7 @@ extern "C" {
 typedef plot sg_plot;
 typedef plot_auto sg_plot_auto;
 
+extern void render_stats_push (lua_State *L, const render_stats& st);
+extern void svg_options_lookup (lua_State *L, int index, svg_stream::options& opt);
+
 #endif
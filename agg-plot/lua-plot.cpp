@@ -72,6 +72,8 @@ static int plot_set_legend     (lua_State *L);
 static int plot_get_legend     (lua_State *L);
 static int plot_xaxis_hol_set  (lua_State *L);
 static int plot_xaxis_hol_clear(lua_State *L);
+static int plot_stats          (lua_State *L);
+static int plot_reset_stats    (lua_State *L);
 
 static int plot_sync_mode_get (lua_State *L);
 static int plot_sync_mode_set (lua_State *L);
@@ -113,6 +115,8 @@ static const struct luaL_Reg plot_methods[] = {
     {"get_legend",  plot_get_legend},
     {"set_multi_labels",     plot_xaxis_hol_set},
     {"clear_multi_labels",   plot_xaxis_hol_clear},
+    {"stats",       plot_stats      },
+    {"reset_stats", plot_reset_stats},
     {NULL, NULL}
 };
 
@@ -646,6 +650,76 @@ plot_clear (lua_State *L)
     return 0;
 }
 
+void
+render_stats_push (lua_State *L, const render_stats& st)
+{
+    static const char * const phase_names[render_stats::phase_count] = {
+        "layout", "axis", "elements", "blit", "lock_wait"
+    };
+
+    lua_newtable(L);
+    for (int k = 0; k < render_stats::phase_count; k++)
+    {
+        lua_pushnumber(L, st.time[k]);
+        lua_setfield(L, -2, phase_names[k]);
+    }
+    lua_pushnumber(L, st.draws);
+    lua_setfield(L, -2, "draws");
+    lua_pushnumber(L, st.updates);
+    lua_setfield(L, -2, "updates");
+    lua_pushnumber(L, st.items);
+    lua_setfield(L, -2, "items");
+    lua_pushnumber(L, st.vertices);
+    lua_setfield(L, -2, "vertices");
+}
+
+int
+plot_stats (lua_State *L)
+{
+    sg_plot *p = object_check<sg_plot>(L, 1, GS_PLOT);
+    AGG_LOCK();
+    render_stats st = p->stats();
+    AGG_UNLOCK();
+    render_stats_push(L, st);
+    return 1;
+}
+
+int
+plot_reset_stats (lua_State *L)
+{
+    sg_plot *p = object_check<sg_plot>(L, 1, GS_PLOT);
+    AGG_LOCK();
+    p->reset_stats();
+    render_stats_vertices = true;
+    AGG_UNLOCK();
+    return 0;
+}
+
+/* read the fields "precision", "relative" and "decimate" of the
+   optional table at "index" */
+void
+svg_options_lookup (lua_State *L, int index, svg_stream::options& opt)
+{
+    if (lua_isnoneornil(L, index))
+        return;
+    if (!lua_istable(L, index))
+        luaL_error(L, "expecting a table of options as argument #%d", index);
+
+    lua_getfield(L, index, "precision");
+    if (!lua_isnil(L, -1))
+        opt.precision = luaL_checkinteger(L, -1);
+    lua_pop(L, 1);
+
+    lua_getfield(L, index, "relative");
+    opt.relative = lua_toboolean(L, -1);
+    lua_pop(L, 1);
+
+    lua_getfield(L, index, "decimate");
+    if (!lua_isnil(L, -1))
+        opt.decimation = luaL_checknumber(L, -1);
+    lua_pop(L, 1);
+}
+
 int
 plot_save_svg (lua_State *L)
 {
@@ -653,10 +727,13 @@ plot_save_svg (lua_State *L)
     const char *filename = lua_tostring(L, 2);
     double w = luaL_optnumber(L, 3, 800.0);
     double h = luaL_optnumber(L, 4, 600.0);
+    svg_stream::options opt;
 
     if (!filename)
         return gs_type_error(L, 2, "string");
 
+    svg_options_lookup(L, 5, opt);
+
     unsigned fnlen = strlen(filename);
     if (fnlen <= 4 || strcmp(filename + (fnlen - 4), ".svg") != 0)
     {
@@ -669,7 +746,7 @@ plot_save_svg (lua_State *L)
     if (!f)
         return luaL_error(L, "cannot open filename: %s", filename);
 
-    canvas_svg canvas(f, h);
+    canvas_svg canvas(f, h, opt);
     agg::trans_affine_scaling m(w, h);
     canvas.write_header(w, h);
     p->draw(canvas, m, NULL);
@@ -0,0 +1,307 @@
+/* mesh3d.cpp
+ *
+ * Copyright (C) 2013 Francesco Abbate
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "agg_conv_contour.h"
+
+#include "mesh3d.h"
+
+namespace {
+
+// a single face already transformed to the canvas coordinates
+class face_polygon : public sg_object {
+public:
+    face_polygon(): m_n(0), m_k(0) { }
+
+    void set(unsigned n, const double* xs, const double* ys)
+    {
+        m_n = n;
+        for (unsigned k = 0; k < n; k++)
+        {
+            m_x[k] = xs[k];
+            m_y[k] = ys[k];
+        }
+    }
+
+    virtual void rewind(unsigned path_id) { m_k = 0; }
+
+    virtual unsigned vertex(double* x, double* y)
+    {
+        if (m_k < m_n)
+        {
+            *x = m_x[m_k];
+            *y = m_y[m_k];
+            return (m_k++ == 0 ? agg::path_cmd_move_to : agg::path_cmd_line_to);
+        }
+        if (m_k++ == m_n)
+            return agg::path_cmd_end_poly | agg::path_flags_close;
+        return agg::path_cmd_stop;
+    }
+
+    virtual void apply_transform(const agg::trans_affine& m, double as) { }
+
+    virtual void bounding_box(double *x1, double *y1, double *x2, double *y2)
+    {
+        agg::bounding_rect_single(*this, 0, x1, y1, x2, y2);
+    }
+
+private:
+    unsigned m_n, m_k;
+    double m_x[4], m_y[4];
+};
+
+typedef sg_adapter<agg::conv_contour<sg_object>, no_approx_scale> face_extend;
+
+inline agg::rgba8 shade(agg::rgba8 c, double f)
+{
+    return agg::rgba8(agg::int8u(c.r * f), agg::int8u(c.g * f), agg::int8u(c.b * f), c.a);
+}
+
+}
+
+namespace draw {
+
+mesh3d::mesh3d(unsigned nv, unsigned nf, const options& opt):
+    m_nv(nv), m_nf(nf), m_vertices(3 * nv), m_faces(4 * nf),
+    m_options(opt), m_rx(0), m_ry(0), m_distance(10), m_focal(10),
+    m_radius(0), m_dirty(true),
+    m_camera_vertices(3 * nv), m_projected(2 * nv), m_order(nf),
+    m_nvisible(0), m_iter_face(0), m_iter_vertex(0)
+{
+}
+
+void mesh3d::set_camera(double rx, double ry, double distance, double focal)
+{
+    m_rx = rx;
+    m_ry = ry;
+    m_distance = distance;
+    m_focal = focal;
+    m_dirty = true;
+}
+
+int mesh3d::face_entry_cmp(const void* pa, const void* pb)
+{
+    const face_entry* a = (const face_entry*) pa;
+    const face_entry* b = (const face_entry*) pb;
+    if (a->depth != b->depth)
+        return a->depth < b->depth ? -1 : 1;
+    return a->index < b->index ? -1 : (a->index > b->index ? 1 : 0);
+}
+
+void mesh3d::update()
+{
+    if (!m_dirty)
+        return;
+
+    const double sx = sin(m_rx), cx = cos(m_rx);
+    const double sy = sin(m_ry), cy = cos(m_ry);
+
+    double r2max = 0;
+    for (unsigned k = 0; k < m_nv; k++)
+    {
+        const double* v = &m_vertices[3*k];
+        double r2 = v[0]*v[0] + v[1]*v[1] + v[2]*v[2];
+        if (r2 > r2max) r2max = r2;
+
+        // rotation around the x axis followed by the y axis
+        double y1 = cx * v[1] - sx * v[2], z1 = sx * v[1] + cx * v[2];
+        double x2 = cy * v[0] + sy * z1, z2 = -sy * v[0] + cy * z1;
+        double* w = &m_camera_vertices[3*k];
+        w[0] = x2;
+        w[1] = y1;
+        w[2] = z2 - m_distance;
+
+        double* p = &m_projected[2*k];
+        if (w[2] < 0)
+        {
+            double s = m_focal / (-w[2]);
+            p[0] = w[0] * s;
+            p[1] = w[1] * s;
+        }
+        else
+        {
+            p[0] = p[1] = 0;
+        }
+    }
+    m_radius = sqrt(r2max);
+
+    m_nvisible = 0;
+    for (unsigned k = 0; k < m_nf; k++)
+    {
+        const unsigned* f = &m_faces[4*k];
+        const unsigned n = face_size(k);
+        const double* w[4];
+        double c[3] = {0, 0, 0};
+        bool behind = false;
+        for (unsigned j = 0; j < n; j++)
+        {
+            w[j] = &m_camera_vertices[3*f[j]];
+            c[0] += w[j][0];
+            c[1] += w[j][1];
+            c[2] += w[j][2];
+            if (w[j][2] >= 0) behind = true;
+        }
+        c[0] /= n; c[1] /= n; c[2] /= n;
+
+        // faces behind or too close to the camera are culled
+        if (behind || c[2] >= -1)
+            continue;
+
+        double a[3], b[3], n1[3], n2[3];
+        for (int q = 0; q < 3; q++)
+        {
+            a[q] = w[1][q] - w[0][q];
+            b[q] = w[2][q] - w[0][q];
+        }
+        n1[0] = a[1]*b[2] - a[2]*b[1];
+        n1[1] = a[2]*b[0] - a[0]*b[2];
+        n1[2] = a[0]*b[1] - a[1]*b[0];
+        if (n == 4)
+        {
+            for (int q = 0; q < 3; q++)
+                a[q] = w[3][q] - w[0][q];
+            n2[0] = b[1]*a[2] - b[2]*a[1];
+            n2[1] = b[2]*a[0] - b[0]*a[2];
+            n2[2] = b[0]*a[1] - b[1]*a[0];
+        }
+        else
+        {
+            n2[0] = n1[0]; n2[1] = n1[1]; n2[2] = n1[2];
+        }
+
+        // a face is back-facing if both its triangles point away from
+        // the eye at the origin
+        if (!m_options.backfaces)
+        {
+            double d1 = c[0]*n1[0] + c[1]*n1[1] + c[2]*n1[2];
+            double d2 = c[0]*n2[0] + c[1]*n2[1] + c[2]*n2[2];
+            if (d1 > 0 && d2 > 0)
+                continue;
+        }
+
+        // the light comes from the camera along the z axis
+        double nn = sqrt(n1[0]*n1[0] + n1[1]*n1[1] + n1[2]*n1[2]);
+        double intensity = (nn > 0 ? n1[2] / nn : 0);
+
+        face_entry& e = m_order[m_nvisible++];
+        e.depth = c[2];
+        e.index = k;
+        e.back = (intensity < 0);
+        e.intensity = float(intensity < 0 ? -intensity : intensity);
+    }
+
+    // painter's algorithm: the farthest faces, with the most negative
+    // z, are drawn first
+    if (m_nvisible > 1)
+        qsort(&m_order[0], m_nvisible, sizeof(face_entry), face_entry_cmp);
+
+    m_dirty = false;
+}
+
+void mesh3d::rewind(unsigned path_id)
+{
+    update();
+    m_iter_face = 0;
+    m_iter_vertex = 0;
+}
+
+unsigned mesh3d::vertex(double* x, double* y)
+{
+    if (m_iter_face >= m_nvisible)
+        return agg::path_cmd_stop;
+
+    const unsigned k = m_order[m_iter_face].index;
+    if (m_iter_vertex < face_size(k))
+    {
+        const double* p = &m_projected[2*m_faces[4*k + m_iter_vertex]];
+        *x = p[0];
+        *y = p[1];
+        return (m_iter_vertex++ == 0 ? agg::path_cmd_move_to : agg::path_cmd_line_to);
+    }
+
+    m_iter_face++;
+    m_iter_vertex = 0;
+    return agg::path_cmd_end_poly | agg::path_flags_close;
+}
+
+// The bounding box is the projection of the sphere around the origin
+// that contains all the vertices. It does not change with the camera
+// angles so that the plot limits stay the same when the mesh rotates.
+void mesh3d::bounding_box(double *x1, double *y1, double *x2, double *y2)
+{
+    update();
+    if (m_distance > m_radius && m_radius > 0)
+    {
+        double e = m_focal * m_radius / (m_distance - m_radius);
+        *x1 = *y1 = -e;
+        *x2 = *y2 = e;
+    }
+    else
+    {
+        agg::bounding_rect_single(*this, 0, x1, y1, x2, y2);
+    }
+}
+
+bool mesh3d::draw_parts(virtual_canvas& canvas, const agg::trans_affine& m, agg::rgba8 c)
+{
+    update();
+
+    const agg::rgba8 front = (m_options.own_color ? m_options.color : c);
+    const agg::rgba8 back = (m_options.own_back_color ? m_options.back_color : front);
+
+    face_polygon face;
+    face_extend face_ext(&face);
+    // the faces are enlarged by a fraction of pixel to hide the seams
+    // between adjacent faces
+    face_ext.self().width(0.5);
+    face_ext.self().auto_detect_orientation(true);
+
+    double xs[4], ys[4];
+    for (unsigned j = 0; j < m_nvisible; j++)
+    {
+        const face_entry& e = m_order[j];
+        const unsigned n = face_size(e.index);
+        for (unsigned q = 0; q < n; q++)
+        {
+            const double* p = &m_projected[2*m_faces[4*e.index + q]];
+            xs[q] = p[0];
+            ys[q] = p[1];
+            m.transform(&xs[q], &ys[q]);
+        }
+        face.set(n, xs, ys);
+
+        agg::rgba8 col = (e.back ? back : front);
+        if (m_options.light)
+            col = shade(col, 0.2 + 0.8 * e.intensity);
+
+        if (m_options.overdraw)
+            canvas.draw(face_ext, col);
+        else
+            canvas.draw(face, col);
+
+        if (m_options.stroke)
+            canvas.draw_outline(face, m_options.stroke_color);
+    }
+
+    return true;
+}
+
+}
@@ -0,0 +1,113 @@
+/* mesh3d.h
+ *
+ * Copyright (C) 2013 Francesco Abbate
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef AGGPLOT_MESH3D_H
+#define AGGPLOT_MESH3D_H
+
+#include "agg_array.h"
+#include "agg_color_rgba.h"
+
+#include "sg_object.h"
+#include "canvas.h"
+
+namespace draw {
+
+// A mesh of triangles and quadrilaterals in the 3D space seen by a
+// pinhole camera looking down the negative z axis. The vertices are
+// rotated around the x and then the y axis and moved at the given
+// distance from the camera. The faces are projected, culled, shaded
+// according to their orientation and sorted by depth each time the
+// camera changes so that a redraw only replays the sorted faces.
+class mesh3d : public sg_object {
+public:
+    enum { no_vertex = 0xffffffff };
+
+    // when "own_color" is false the faces take the color given when
+    // the mesh is added to the plot
+    struct options {
+        agg::rgba8 color, back_color, stroke_color;
+        bool own_color, own_back_color, stroke;
+        bool light, backfaces, overdraw;
+    };
+
+    mesh3d(unsigned nv, unsigned nf, const options& opt);
+
+    // coordinates of the vertex k
+    void set_vertex(unsigned k, double x, double y, double z)
+    {
+        double* v = &m_vertices[3*k];
+        v[0] = x; v[1] = y; v[2] = z;
+        m_dirty = true;
+    }
+
+    // vertices of the face k, i3 is equal to no_vertex for a triangle
+    void set_face(unsigned k, unsigned i0, unsigned i1, unsigned i2, unsigned i3)
+    {
+        unsigned* f = &m_faces[4*k];
+        f[0] = i0; f[1] = i1; f[2] = i2; f[3] = i3;
+        m_dirty = true;
+    }
+
+    void set_camera(double rx, double ry, double distance, double focal);
+
+    unsigned visible_faces() { update(); return m_nvisible; }
+
+    virtual void rewind(unsigned path_id);
+    virtual unsigned vertex(double* x, double* y);
+
+    virtual void apply_transform(const agg::trans_affine& m, double as) { }
+    virtual void bounding_box(double *x1, double *y1, double *x2, double *y2);
+
+    virtual bool draw_parts(virtual_canvas& canvas, const agg::trans_affine& m, agg::rgba8 c);
+
+private:
+    struct face_entry {
+        double depth;
+        unsigned index;
+        float intensity;
+        bool back;
+    };
+
+    static int face_entry_cmp(const void* pa, const void* pb);
+
+    void update();
+    unsigned face_size(unsigned k) const { return m_faces[4*k+3] == no_vertex ? 3 : 4; }
+
+    unsigned m_nv, m_nf;
+    agg::pod_array<double> m_vertices;
+    agg::pod_array<unsigned> m_faces;
+
+    options m_options;
+    double m_rx, m_ry, m_distance, m_focal;
+    double m_radius; // radius of the sphere around the origin with all the vertices
+
+    // data calculated by update() from the vertices and the camera
+    bool m_dirty;
+    agg::pod_array<double> m_camera_vertices; // coordinates in the camera space
+    agg::pod_array<double> m_projected;       // projection on the plane
+    agg::pod_array<face_entry> m_order;       // visible faces, farthest first
+    unsigned m_nvisible;
+
+    // position of the vertex iterator
+    unsigned m_iter_face, m_iter_vertex;
+};
+
+}
+
+#endif
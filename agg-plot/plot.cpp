@@ -1,5 +1,7 @@
 #include "plot.h"
 
+bool render_stats_vertices = false;
+
 static double compute_scale(const agg::trans_affine& m)
 {
     return m.scale() / 480.0;
@@ -63,31 +65,66 @@ static bool area_is_valid(const agg::trans_affine& b)
 void plot::draw_virtual_canvas(canvas_type& canvas, plot_layout& layout, const agg::rect_i* clip)
 {
     before_draw();
-    draw_legends(canvas, layout);
 
     if (area_is_valid(layout.plot_area))
     {
-        draw_axis(canvas, layout, clip);
+        {
+            render_timer timer(m_stats.time[render_stats::axis]);
+            draw_legends(canvas, layout);
+            draw_axis(canvas, layout, clip);
+        }
+        render_timer timer(m_stats.time[render_stats::elements]);
         draw_elements(canvas, layout);
     }
+    else
+    {
+        render_timer timer(m_stats.time[render_stats::axis]);
+        draw_legends(canvas, layout);
+    }
 };
 
 void plot::draw_simple(canvas_type& canvas, plot_layout& layout, const agg::rect_i* clip)
 {
     before_draw();
-    draw_axis(canvas, layout, clip);
+    {
+        render_timer timer(m_stats.time[render_stats::axis]);
+        draw_axis(canvas, layout, clip);
+    }
+    render_timer timer(m_stats.time[render_stats::elements]);
     draw_elements(canvas, layout);
 };
 
+// draw the text from the cached glyphs when possible
+static void draw_text(virtual_canvas& canvas, draw::text& label, agg::rgba8 c)
+{
+    if (!label.draw_parts(canvas, identity_matrix, c))
+        canvas.draw(label, c);
+}
+
 void plot::draw_element(item& c, canvas_type& canvas, const agg::trans_affine& m)
 {
     sg_object& vs = c.content();
     vs.apply_transform(m, 1.0);
 
+    m_stats.items++;
+    if (!c.outline && vs.draw_parts(canvas, identity_matrix, c.color))
+        return;
+
+    if (!render_stats_vertices)
+    {
+        if (c.outline)
+            canvas.draw_outline(vs, c.color);
+        else
+            canvas.draw(vs, c.color);
+        return;
+    }
+
+    sg_vertex_counter counted(vs, m_stats.vertices);
+
     if (c.outline)
-        canvas.draw_outline(vs, c.color);
+        canvas.draw_outline(counted, c.color);
     else
-        canvas.draw(vs, c.color);
+        canvas.draw(counted, c.color);
 }
 
 agg::trans_affine plot::get_model_matrix(const plot_layout& layout)
@@ -441,7 +478,7 @@ void plot::draw_legends(canvas_type& canvas, const plot_layout& layout)
         draw::text title(m_title.cstr(), layout.title_font_size, 0.5, 0.0);
         title.set_point(pos.x, pos.y);
         title.apply_transform(identity_matrix, 1.0);
-        canvas.draw(title, colors::black);
+        draw_text(canvas, title, colors::black);
     }
 
     for (int k = 0; k < 4; k++)
@@ -563,14 +600,14 @@ void plot::draw_axis(canvas_type& canvas, plot_layout& layout, const agg::rect_i
     {
         draw::text* label = xlabels[j];
         label->apply_transform(m_xlabels, 1.0);
-        canvas.draw(*label, colors::black);
+        draw_text(canvas, *label, colors::black);
     }
 
     for (unsigned j = 0; j < ylabels.size(); j++)
     {
         draw::text* label = ylabels[j];
         label->apply_transform(m, 1.0);
-        canvas.draw(*label, colors::black);
+        draw_text(canvas, *label, colors::black);
     }
 
     lndash.add_dash(7.0, 3.0);
@@ -597,7 +634,7 @@ void plot::draw_axis(canvas_type& canvas, plot_layout& layout, const agg::rect_i
         xlabel.set_point(labx, laby);
         xlabel.apply_transform(identity_matrix, 1.0);
 
-        canvas.draw(xlabel, colors::black);
+        draw_text(canvas, xlabel, colors::black);
     }
 
     if (!str_is_null(&m_y_axis.title))
@@ -611,7 +648,7 @@ void plot::draw_axis(canvas_type& canvas, plot_layout& layout, const agg::rect_i
         ylabel.angle(M_PI/2.0);
         ylabel.apply_transform(identity_matrix, 1.0);
 
-        canvas.draw(ylabel, colors::black);
+        draw_text(canvas, ylabel, colors::black);
     }
 
     if (clip)
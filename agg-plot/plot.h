@@ -37,6 +37,7 @@
 #include "categories.h"
 #include "sg_object.h"
 #include "factor_labels.h"
+#include "render_stats.h"
 
 #include "agg_array.h"
 #include "agg_bounding_rect.h"
@@ -60,6 +61,9 @@ public:
     virtual void draw_outline(sg_object& vs, agg::rgba8 c) {
         m_canvas->draw_outline(vs, c);
     }
+    virtual bool draw_text(const text_layout& layout, double x, double y, agg::rgba8 c) {
+        return m_canvas->draw_text(layout, x, y, c);
+    }
 
     virtual void clip_box(const agg::rect_base<int>& clip) {
         m_canvas->clip_box(clip);
@@ -332,8 +336,9 @@ public:
     {
         canvas_adapter<Canvas> vc(&canvas);
         agg::rect_i clip = rect_of_slot_matrix<int>(m);
-        plot_layout layout = compute_plot_layout(m);
+        plot_layout layout = timed_plot_layout(m);
         draw_virtual_canvas(vc, layout, &clip);
+        m_stats.draws++;
         if (inf)
             inf->active_area = layout.plot_active_area;
     }
@@ -343,8 +348,9 @@ public:
     {
         canvas_adapter<Canvas> vc(&canvas);
         agg::trans_affine mtx = affine_matrix(r);
-        plot_layout layout = compute_plot_layout(mtx);
+        plot_layout layout = timed_plot_layout(mtx);
         draw_virtual_canvas(vc, layout, &r);
+        m_stats.draws++;
         if (inf)
             inf->active_area = layout.plot_active_area;
     }
@@ -373,6 +379,9 @@ public:
     template <class Canvas>
     void draw_queue(Canvas& canvas, const agg::trans_affine& m, const plot_render_info& inf, opt_rect<double>& bbox);
 
+    const render_stats& stats() const { return m_stats; }
+    void reset_stats() { m_stats.reset(); }
+
     void sync_mode(bool req_mode) {
         m_sync_mode = req_mode;
     };
@@ -451,6 +460,12 @@ protected:
 
     plot_layout compute_plot_layout(const agg::trans_affine& canvas_mtx, bool do_legends = true);
 
+    plot_layout timed_plot_layout(const agg::trans_affine& canvas_mtx)
+    {
+        render_timer timer(m_stats.time[render_stats::layout]);
+        return compute_plot_layout(canvas_mtx);
+    }
+
     // return the matrix that map from plot coordinates to screen
     // coordinates
     agg::trans_affine get_model_matrix(const plot_layout& layout);
@@ -496,6 +511,8 @@ protected:
     bool m_use_units;
     units m_ux, m_uy;
 
+    render_stats m_stats;
+
 private:
     item_list m_root_layer;
     agg::pod_auto_vector<item_list*, max_layers> m_layers;
@@ -518,9 +535,12 @@ void plot::draw_queue(Canvas& _canvas, const agg::trans_affine& canvas_mtx, cons
     canvas_adapter<Canvas> canvas(&_canvas);
     before_draw();
 
-    plot_layout layout = compute_plot_layout(canvas_mtx);
+    plot_layout layout = timed_plot_layout(canvas_mtx);
     layout.plot_active_area = inf.active_area;
 
+    render_timer timer(m_stats.time[render_stats::elements]);
+    m_stats.updates++;
+
     this->clip_plot_area(canvas, layout.plot_active_area);
 
     typedef typename plot::iterator iter_type;
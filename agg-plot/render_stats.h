@@ -0,0 +1,141 @@
+/* render_stats.h
+ *
+ * Copyright (C) 2013 Francesco Abbate
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef AGGPLOT_RENDER_STATS_H
+#define AGGPLOT_RENDER_STATS_H
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#include "sg_object.h"
+
+// Counters of the work done to render a plot or a window. The times
+// are accumulated in seconds for each phase of the rendering.
+struct render_stats {
+    enum phase_e { layout = 0, axis, elements, blit, lock_wait, phase_count };
+
+    double time[phase_count];
+    unsigned long draws;     // complete redraws
+    unsigned long updates;   // incremental updates of the drawing queue
+    unsigned long items;     // graphical elements rasterized
+    unsigned long vertices;  // vertices of the rasterized elements
+
+    render_stats() { reset(); }
+
+    void reset()
+    {
+        for (int k = 0; k < phase_count; k++)
+            time[k] = 0.0;
+        draws = updates = items = vertices = 0;
+    }
+
+    // add the difference between two snapshots of another counter
+    void add_delta(const render_stats& before, const render_stats& after)
+    {
+        for (int k = 0; k < phase_count; k++)
+            time[k] += after.time[k] - before.time[k];
+        draws    += after.draws    - before.draws;
+        updates  += after.updates  - before.updates;
+        items    += after.items    - before.items;
+        vertices += after.vertices - before.vertices;
+    }
+};
+
+static inline double render_clock()
+{
+#ifdef WIN32
+    LARGE_INTEGER freq, t;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&t);
+    return double(t.QuadPart) / double(freq.QuadPart);
+#else
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return double(t.tv_sec) + double(t.tv_nsec) * 1.0e-9;
+#endif
+}
+
+// Add to a counter the time elapsed during the lifetime of the object.
+class render_timer {
+public:
+    render_timer(double& acc): m_acc(acc), m_start(render_clock()) { }
+    ~render_timer() { m_acc += render_clock() - m_start; }
+
+private:
+    double& m_acc;
+    double m_start;
+};
+
+// The vertices are counted only when this flag is set since the
+// counting adds a virtual call for each vertex drawn. It is enabled
+// by the first call to the reset_stats method of a plot or a window.
+extern bool render_stats_vertices;
+
+// Vertex source adapter that counts the vertices read from the
+// underlying graphical object.
+class sg_vertex_counter : public sg_object {
+public:
+    sg_vertex_counter(sg_object& src, unsigned long& count):
+        m_src(src), m_count(count)
+    { }
+
+    virtual void rewind(unsigned path_id) { m_src.rewind(path_id); }
+
+    virtual unsigned vertex(double* x, double* y)
+    {
+        unsigned cmd = m_src.vertex(x, y);
+        if (!agg::is_stop(cmd))
+            m_count++;
+        return cmd;
+    }
+
+    virtual void apply_transform(const agg::trans_affine& m, double as)
+    {
+        m_src.apply_transform(m, as);
+    }
+
+    virtual void bounding_box(double *x1, double *y1, double *x2, double *y2)
+    {
+        m_src.bounding_box(x1, y1, x2, y2);
+    }
+
+    virtual bool affine_compose(agg::trans_affine& m)
+    {
+        return m_src.affine_compose(m);
+    }
+
+    virtual void write_svg(svg_stream& s, int id, agg::rgba8 c, double h)
+    {
+        m_src.write_svg(s, id, c, h);
+    }
+
+    virtual svg_property_list* svg_path(svg_stream& s, double h)
+    {
+        return m_src.svg_path(s, h);
+    }
+
+private:
+    sg_object& m_src;
+    unsigned long& m_count;
+};
+
+#endif
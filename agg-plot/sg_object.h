@@ -34,6 +34,8 @@
 #include "resource-manager.h"
 #include "strpp.h"
 
+struct virtual_canvas;
+
 struct vertex_source {
     virtual void rewind(unsigned path_id) = 0;
     virtual unsigned vertex(double* x, double* y) = 0;
@@ -50,15 +52,23 @@ struct sg_object : public vertex_source {
         return false;
     }
 
-    virtual str write_svg(int id, agg::rgba8 c, double h) {
-        str path;
-        svg_property_list* ls = this->svg_path(path, h);
-        str s = svg_fill_path(path, id, c, ls);
+    // Objects made of parts with different colors draw each part on
+    // the canvas, with the coordinates transformed by "m", and return
+    // true. The other objects are drawn as a single path.
+    virtual bool draw_parts(virtual_canvas& canvas, const agg::trans_affine& m, agg::rgba8 c) {
+        return false;
+    }
+
+    virtual void write_svg(svg_stream& s, int id, agg::rgba8 c, double h) {
+        svg_begin_path(s);
+        svg_property_list* ls = this->svg_path(s, h);
+        svg_end_fill_path(s, id, c, ls);
         svg_property_list::free(ls);
-        return s;
     }
 
-    virtual svg_property_list* svg_path(str& s, double h) {
+    // write the coordinates of the path and return its additional
+    // SVG properties
+    virtual svg_property_list* svg_path(svg_stream& s, double h) {
         svg_coords_from_vs(this, s, h);
         return 0;
     }
@@ -171,7 +181,7 @@ class sg_object_scaling : public sg_object
 
 public:
     sg_object_scaling(sg_object* src, agg::trans_affine& mtx=identity_matrix):
-        m_source(src), m_trans(*m_source, mtx)
+        m_source(src), m_trans(*m_source, mtx), m_matrix(mtx)
     {
         ResourceManager::acquire(m_source);
     }
@@ -189,7 +199,8 @@ public:
 
     virtual void apply_transform(const agg::trans_affine& m, double as)
     {
-        m_trans.transformer(m);
+        m_matrix = m;
+        m_trans.transformer(m_matrix);
         m_source->apply_transform (m, as * m.scale());
     }
 
@@ -197,6 +208,16 @@ public:
     {
         agg::bounding_rect_single (*m_source, 0, x1, y1, x2, y2);
     }
+
+    virtual bool draw_parts(virtual_canvas& canvas, const agg::trans_affine& m, agg::rgba8 c)
+    {
+        agg::trans_affine mtx = m_matrix;
+        mtx *= m;
+        return m_source->draw_parts(canvas, mtx, c);
+    }
+
+private:
+    agg::trans_affine m_matrix;
 };
 
 template <class ResourceManager>
@@ -227,11 +248,11 @@ public:
         this->m_source->bounding_box(x1, y1, x2, y2);
     }
 
-    virtual str write_svg(int id, agg::rgba8 c, double h) {
-        return this->m_source->write_svg(id, c, h);
+    virtual void write_svg(svg_stream& s, int id, agg::rgba8 c, double h) {
+        this->m_source->write_svg(s, id, c, h);
     }
 
-    virtual svg_property_list* svg_path(str& s, double h) {
+    virtual svg_property_list* svg_path(svg_stream& s, double h) {
         return this->m_source->svg_path(s, h);
     }
 
@@ -239,6 +260,10 @@ public:
         return this->m_source->affine_compose(m);
     }
 
+    virtual bool draw_parts(virtual_canvas& canvas, const agg::trans_affine& m, agg::rgba8 c) {
+        return this->m_source->draw_parts(canvas, m, c);
+    }
+
 private:
     sg_object* m_source;
 };
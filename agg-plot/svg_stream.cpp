@@ -0,0 +1,260 @@
+/* svg_stream.cpp
+ *
+ * Copyright (C) 2013 Francesco Abbate
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <stdarg.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "svg_stream.h"
+
+svg_stream::svg_stream(FILE* f, const options& opt):
+    m_output(f), m_buffer(new char[buffer_size]), m_pos(0), m_options(opt)
+{
+    if (m_options.precision < 0)
+        m_options.precision = 0;
+    if (m_options.precision > 6)
+        m_options.precision = 6;
+    m_scale = 1.0;
+    for (int k = 0; k < m_options.precision; k++)
+        m_scale *= 10.0;
+    path_begin();
+}
+
+svg_stream::~svg_stream()
+{
+    flush();
+    delete [] m_buffer;
+}
+
+void svg_stream::flush()
+{
+    if (m_pos > 0)
+        fwrite(m_buffer, 1, m_pos, m_output);
+    m_pos = 0;
+}
+
+void svg_stream::write(const char* s, unsigned len)
+{
+    if (m_pos + len > buffer_size)
+    {
+        flush();
+        if (len > buffer_size)
+        {
+            fwrite(s, 1, len, m_output);
+            return;
+        }
+    }
+    memcpy(m_buffer + m_pos, s, len);
+    m_pos += len;
+}
+
+void svg_stream::printf(const char* fmt, ...)
+{
+    char buf[256];
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+
+    if (n < 0)
+        return;
+    if (n < int(sizeof(buf)))
+    {
+        write(buf, n);
+        return;
+    }
+
+    char* s = new char[n + 1];
+    va_start(ap, fmt);
+    vsnprintf(s, n + 1, fmt, ap);
+    va_end(ap);
+    write(s, n);
+    delete [] s;
+}
+
+svg_stream::coord_type svg_stream::quantize(double v) const
+{
+    const double limit = 1.0e15;
+    double q = floor(v * m_scale + 0.5);
+    if (q > limit) return coord_type(limit);
+    if (q < -limit || q != q) return coord_type(-limit);
+    return coord_type(q);
+}
+
+// write a fixed point number with the trailing zeros of the decimals
+// removed
+void svg_stream::write_coord(coord_type v)
+{
+    char buf[32];
+    char* p = buf + sizeof(buf);
+    bool neg = (v < 0);
+    if (neg) v = -v;
+
+    int digits = m_options.precision;
+    bool frac = false;
+    for (; digits > 0; digits--, v /= 10)
+    {
+        int d = int(v % 10);
+        if (d != 0 || frac)
+        {
+            *(--p) = char('0' + d);
+            frac = true;
+        }
+    }
+    if (frac)
+        *(--p) = '.';
+
+    do {
+        *(--p) = char('0' + int(v % 10));
+        v /= 10;
+    } while (v > 0);
+
+    if (neg && !(p[0] == '0' && p + 1 == buf + sizeof(buf)))
+        *(--p) = '-';
+
+    write(p, buf + sizeof(buf) - p);
+}
+
+void svg_stream::write_point(coord_type x, coord_type y)
+{
+    if (m_options.relative)
+    {
+        write_coord(x - m_x);
+        put(',');
+        write_coord(y - m_y);
+    }
+    else
+    {
+        write_coord(x);
+        put(',');
+        write_coord(y);
+    }
+}
+
+// write the command letter unless it is the same of the previous
+// one. A line after a move uses the implicit line command. The moves
+// and the close path commands are always explicit since the
+// coordinates after a move are read as lines.
+void svg_stream::command(char cmd)
+{
+    const bool repeat = (cmd != 'Z' && cmd != 'M' && cmd == m_last_cmd);
+    const bool implicit = (repeat || (cmd == 'L' && m_last_cmd == 'M'));
+    if (m_last_cmd != 0)
+        put(' ');
+    if (!implicit)
+        put(m_options.relative ? char(cmd - 'A' + 'a') : cmd);
+    m_last_cmd = cmd;
+}
+
+void svg_stream::path_begin()
+{
+    m_last_cmd = 0;
+    m_x = m_y = 0;
+    m_start_x = m_start_y = 0;
+    m_pending = false;
+}
+
+void svg_stream::flush_pending()
+{
+    if (m_pending)
+    {
+        m_pending = false;
+        coord_type x = quantize(m_pending_x), y = quantize(m_pending_y);
+        command('L');
+        write_point(x, y);
+        m_x = x;
+        m_y = y;
+    }
+}
+
+void svg_stream::move_to(double x, double y)
+{
+    flush_pending();
+    coord_type qx = quantize(x), qy = quantize(y);
+    command('M');
+    write_point(qx, qy);
+    m_x = m_start_x = qx;
+    m_y = m_start_y = qy;
+    m_last_x = x;
+    m_last_y = y;
+}
+
+void svg_stream::line_to(double x, double y)
+{
+    const double d = m_options.decimation;
+    if (d > 0 && fabs(x - m_last_x) < d && fabs(y - m_last_y) < d)
+    {
+        m_pending = true;
+        m_pending_x = x;
+        m_pending_y = y;
+        return;
+    }
+    m_pending = false;
+
+    coord_type qx = quantize(x), qy = quantize(y);
+    command('L');
+    write_point(qx, qy);
+    m_x = qx;
+    m_y = qy;
+    m_last_x = x;
+    m_last_y = y;
+}
+
+void svg_stream::curve3(double x1, double y1, double x, double y)
+{
+    flush_pending();
+    coord_type qx = quantize(x), qy = quantize(y);
+    command('Q');
+    write_point(quantize(x1), quantize(y1));
+    put(' ');
+    write_point(qx, qy);
+    m_x = qx;
+    m_y = qy;
+    m_last_x = x;
+    m_last_y = y;
+}
+
+void svg_stream::curve4(double x1, double y1, double x2, double y2, double x, double y)
+{
+    flush_pending();
+    coord_type qx = quantize(x), qy = quantize(y);
+    command('C');
+    write_point(quantize(x1), quantize(y1));
+    put(' ');
+    write_point(quantize(x2), quantize(y2));
+    put(' ');
+    write_point(qx, qy);
+    m_x = qx;
+    m_y = qy;
+    m_last_x = x;
+    m_last_y = y;
+}
+
+void svg_stream::close_path()
+{
+    flush_pending();
+    command('Z');
+    m_x = m_start_x;
+    m_y = m_start_y;
+}
+
+void svg_stream::path_end()
+{
+    flush_pending();
+}
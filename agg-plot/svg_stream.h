@@ -0,0 +1,106 @@
+/* svg_stream.h
+ *
+ * Copyright (C) 2013 Francesco Abbate
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef AGGPLOT_SVG_STREAM_H
+#define AGGPLOT_SVG_STREAM_H
+
+#include <stdio.h>
+#include <string.h>
+
+// Buffered writer of SVG documents. The path coordinates are written
+// in fixed point with the given number of decimals without using the
+// printf family of functions. Relative path commands and the removal
+// of the line vertices closer than a given distance to the previous
+// one can be optionally enabled.
+class svg_stream {
+public:
+    struct options {
+        options(): precision(2), relative(false), decimation(0.0) { }
+
+        int precision;     // number of decimals of the coordinates
+        bool relative;     // use relative path commands
+        double decimation; // minimum distance in pixels between line vertices
+    };
+
+    svg_stream(FILE* f, const options& opt = options());
+    ~svg_stream();
+
+    void write(const char* s) { write(s, strlen(s)); }
+    void write(const char* s, unsigned len);
+
+    void put(char c)
+    {
+        if (m_pos == buffer_size)
+            flush();
+        m_buffer[m_pos++] = c;
+    }
+
+    void printf(const char* fmt, ...);
+
+    void flush();
+
+    // minimum distance between the line vertices, zero to write all
+    // of them
+    double decimation() const { return m_options.decimation; }
+    void decimation(double d) { m_options.decimation = d; }
+
+    // path data commands, the coordinates are already in the SVG
+    // coordinate system
+    void path_begin();
+    void move_to(double x, double y);
+    void line_to(double x, double y);
+    void curve3(double x1, double y1, double x, double y);
+    void curve4(double x1, double y1, double x2, double y2, double x, double y);
+    void close_path();
+    void path_end();
+
+private:
+    svg_stream(const svg_stream&);
+    svg_stream& operator= (const svg_stream&);
+
+    enum { buffer_size = 1 << 20 };
+
+    typedef long long coord_type;
+
+    coord_type quantize(double v) const;
+    void write_coord(coord_type v);
+    void write_point(coord_type x, coord_type y);
+    void command(char cmd);
+    void flush_pending();
+
+    FILE* m_output;
+    char* m_buffer;
+    unsigned m_pos;
+
+    options m_options;
+    double m_scale;
+
+    // state of the current path: last command, current point and
+    // start of the subpath in fixed point
+    char m_last_cmd;
+    coord_type m_x, m_y;
+    coord_type m_start_x, m_start_y;
+
+    // the last line vertex skipped by the decimation
+    bool m_pending;
+    double m_pending_x, m_pending_y;
+    double m_last_x, m_last_y;
+};
+
+#endif
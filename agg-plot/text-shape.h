@@ -46,7 +46,7 @@ public:
         m_bbox.y2 = ty + m_text_label.get_text_height() + pad;
     }
 
-    virtual str write_svg(int id, agg::rgba8 c, double h)
+    virtual void write_svg(svg_stream& stream, int id, agg::rgba8 c, double h)
     {
         const str& text = m_text_label.text();
         double txt_size = m_size;
@@ -61,7 +61,7 @@ public:
                            "</text>",
                            x, svg_y_coord(y, h), id, int(txt_size), id, text.cstr());
 
-        return s;
+        stream.write(s.cstr());
     }
 
     virtual void apply_transform(const agg::trans_affine& m, double as)
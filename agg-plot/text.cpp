@@ -24,8 +24,16 @@ text::bounding_box(double *x1, double *y1, double *x2, double *y2)
     *y1 = *y2 = m_y;
 }
 
-str
-text::write_svg(int id, agg::rgba8 c, double h)
+bool
+text::draw_parts(virtual_canvas& canvas, const agg::trans_affine& m, agg::rgba8 c)
+{
+    if (!is_unit_matrix(m) || m.tx != 0.0 || m.ty != 0.0)
+        return false;
+    return m_text_label.draw_glyphs(canvas, m_hjustif, m_vjustif, c);
+}
+
+void
+text::write_svg(svg_stream& stream, int id, agg::rgba8 c, double h)
 {
     const agg::trans_affine& m = m_matrix;
 
@@ -34,7 +42,7 @@ text::write_svg(int id, agg::rgba8 c, double h)
 
     const str& content = m_text_label.text();
     if (str_is_null(&content))
-        return s;
+        return;
 
     str style;
     int hjust = lrint(m_hjustif * 2.0);
@@ -78,6 +86,6 @@ text::write_svg(int id, agg::rgba8 c, double h)
         s = txt;
     }
 
-    return s;
+    stream.write(s.cstr());
 }
 }
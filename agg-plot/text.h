@@ -81,7 +81,9 @@ public:
     virtual void apply_transform(const agg::trans_affine& m, double as);
     virtual void bounding_box(double *x1, double *y1, double *x2, double *y2);
 
-    virtual str write_svg(int id, agg::rgba8 c, double h);
+    virtual bool draw_parts(virtual_canvas& canvas, const agg::trans_affine& m, agg::rgba8 c);
+
+    virtual void write_svg(svg_stream& s, int id, agg::rgba8 c, double h);
 };
 }
 
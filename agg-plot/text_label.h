@@ -9,6 +9,8 @@
 #include "agg_font_freetype.h"
 
 #include "sg_object.h"
+#include "canvas.h"
+#include "glyph_cache.h"
 
 struct grid_fit_y_only {
     static void adjust(double& x, double& y) {
@@ -20,7 +22,7 @@ typedef grid_fit_y_only grid_fit;
 
 class text_label
 {
-    enum { scale_x = 100 };
+    enum { scale_x = text_layout::scale_x };
 
     typedef agg::font_engine_freetype_int32 font_engine_type;
     typedef agg::font_cache_manager<font_engine_type> font_manager_type;
@@ -38,6 +40,9 @@ class text_label
     font_engine_type& m_font_eng;
     font_manager_type& m_font_man;
 
+    // glyph positions for the current font size
+    text_layout m_layout;
+
     const agg::trans_affine* m_model_mtx;
     agg::trans_affine m_text_mtx;
     agg::conv_curve<font_manager_type::path_adaptor_type> m_text_curve;
@@ -50,7 +55,6 @@ public:
         m_model_mtx(&identity_matrix),
         m_text_curve(m_font_man.path_adaptor()), m_text_trans(m_text_curve, m_text_mtx)
     {
-        update_font_size();
         m_width = get_text_width();
     }
 
@@ -76,8 +80,8 @@ public:
         if (m_pos >= m_text_buf.len())
             return false;
 
-        char c = m_text_buf[m_pos];
-        const agg::glyph_cache *glyph = m_font_man.glyph(c);
+        const unsigned code = (unsigned char) m_text_buf[m_pos];
+        const agg::glyph_cache *glyph = m_font_man.glyph(code);
         m_font_man.add_kerning(&m_x, &m_y);
         m_font_man.init_embedded_adaptors(glyph, 0, 0);
 
@@ -105,6 +109,7 @@ public:
 
     void rewind(double hjustif, double vjustif)
     {
+        font_lock_scope lock;
         m_x = scale_x * (- hjustif * m_width);
         m_y = - 0.86 * vjustif * m_font_height;
         m_advance_x = 0;
@@ -121,6 +126,7 @@ public:
 
     unsigned vertex(double* x, double* y)
     {
+        font_lock_scope lock;
         unsigned cmd = m_text_trans.vertex(x, y);
         if (agg::is_stop(cmd))
         {
@@ -144,22 +150,27 @@ public:
 
     double get_text_width()
     {
-        unsigned text_length = m_text_buf.len();
-        double x = 0, y = 0;
-
-        const char* text = m_text_buf.cstr();
-        for (const char* p = text; p < text + text_length; p++)
-        {
-            const agg::glyph_cache* glyph = m_font_man.glyph(*p);
+        font_lock_scope lock;
+        return layout().text_width();
+    }
 
-            if (glyph)
-            {
-                m_font_man.add_kerning(&x, &y);
-                x += glyph->advance_x;
-            }
-        }
+    const text_layout& layout()
+    {
+        m_layout.update(m_text_buf.cstr(), m_text_buf.len(), m_font_height, m_font_width);
+        return m_layout;
+    }
 
-        return x / double(scale_x);
+    // Draw the text using the cached coverage of the glyphs. It is
+    // possible only if the model matrix is a translation, otherwise
+    // the text should be drawn from the glyph outlines.
+    bool draw_glyphs(virtual_canvas& canvas, double hjustif, double vjustif, agg::rgba8 c)
+    {
+        const agg::trans_affine& m = *m_model_mtx;
+        if (!is_unit_matrix(m))
+            return false;
+        double x = m.tx - hjustif * m_width;
+        double y = m.ty - 0.86 * vjustif * m_font_height;
+        return canvas.draw_text(layout(), x, y, c);
     }
 
 private:
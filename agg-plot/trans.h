@@ -35,12 +35,11 @@ struct trans {
             m_width = w;
         }
 
-        virtual str write_svg(int id, agg::rgba8 c, double h) {
-            str path;
-            svg_property_list* ls = this->m_source->svg_path(path, h);
-            str s = svg_stroke_path(path, m_width, id, c, ls);
+        virtual void write_svg(svg_stream& s, int id, agg::rgba8 c, double h) {
+            svg_begin_path(s);
+            svg_property_list* ls = this->m_source->svg_path(s, h);
+            svg_end_stroke_path(s, m_width, id, c, ls);
             svg_property_list::free(ls);
-            return s;
         }
 
     private:
@@ -62,7 +61,7 @@ struct trans {
     public:
         curve_a(sg_object* src) : base_type(src) { }
 
-        virtual svg_property_list* svg_path(str& s, double h) {
+        virtual svg_property_list* svg_path(svg_stream& s, double h) {
             svg_curve_coords_from_vs(this->m_source, s, h);
             return 0;
         }
@@ -83,7 +82,7 @@ struct trans {
     public:
         dash_a(sg_object* src) : base_type(src), m_dasharray(16) { }
 
-        virtual svg_property_list* svg_path(str& s, double h) {
+        virtual svg_property_list* svg_path(svg_stream& s, double h) {
             svg_property_list* ls = this->m_source->svg_path(s, h);
             svg_property_item item(stroke_dasharray, m_dasharray.cstr());
             ls = new svg_property_list(item, ls);
@@ -172,15 +171,21 @@ struct trans {
             m_symbol->apply_transform(m_scale, 1.0);
         }
 
-        virtual str write_svg(int id, agg::rgba8 c, double h) {
+        virtual void write_svg(svg_stream& s, int id, agg::rgba8 c, double h) {
             str marker_id;
-            str marker_def = gen_svg_marker_def(id, c, marker_id);
-
-            str path;
-            svg_property_list* ls = m_source->svg_path(path, h);
+            write_svg_marker_def(s, id, c, marker_id);
+            s.write("\n   ");
 
             str marker_url = gen_marker_url(marker_id);
             const char* murl = marker_url.cstr();
+
+            // each vertex is a marker so none of them can be removed
+            // by the decimation
+            const double decimation = s.decimation();
+            s.decimation(0.0);
+            svg_begin_path(s);
+            svg_property_list* ls = m_source->svg_path(s, h);
+            s.decimation(decimation);
             svg_property_item item1(marker_start, murl);
             svg_property_item item2(marker_mid, murl);
             svg_property_item item3(marker_end, murl);
@@ -188,10 +193,8 @@ struct trans {
             ls = new svg_property_list(item2, ls);
             ls = new svg_property_list(item3, ls);
 
-            str svg = svg_marker_path(path, m_size, id, ls);
+            svg_end_marker_path(s, m_size, id, ls);
             svg_property_list::free(ls);
-
-            return str::print("%s\n   %s", marker_def.cstr(), svg.cstr());
         }
 
         virtual ~marker_a() {
@@ -209,7 +212,7 @@ struct trans {
         agg::trans_affine_scaling m_scale;
         sg_object* m_symbol;
 
-        str gen_svg_marker_def(int id, agg::rgba8 c, str& marker_id) {
+        void write_svg_marker_def(svg_stream& s, int id, agg::rgba8 c, str& marker_id) {
 
             const double pad = 2.0;
 
@@ -223,21 +226,16 @@ struct trans {
             const double S = m_size + 2*pad;
             const double wf = S / m_size;
 
-            str marker_svg = m_symbol->write_svg(-1, c, S);
-
-            str s = str::print("<defs><marker id=\"%s\" "
-                               "refX=\"%g\" refY=\"%g\" "
-                               "viewBox=\"0 0 %g %g\" orient=\"0\" "
-                               "markerWidth=\"%g\" markerHeight=\"%g\">"
-                               "%s"
-                               "</marker></defs>",
-                               marker_id.cstr(), S/2, S/2, S, S, wf, wf,
-                               marker_svg.cstr());
+            s.printf("<defs><marker id=\"%s\" "
+                     "refX=\"%g\" refY=\"%g\" "
+                     "viewBox=\"0 0 %g %g\" orient=\"0\" "
+                     "markerWidth=\"%g\" markerHeight=\"%g\">",
+                     marker_id.cstr(), S/2, S/2, S, S, wf, wf);
+            m_symbol->write_svg(s, -1, c, S);
+            s.write("</marker></defs>");
 
             m_scale.tx = tx_save;
             m_scale.ty = ty_save;
-
-            return s;
         }
 
         static str gen_marker_url(str& marker_id) {
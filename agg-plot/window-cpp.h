@@ -15,6 +15,7 @@ extern "C" {
 #include "agg_color_rgba.h"
 #include "agg_trans_affine.h"
 #include "split-parser.h"
+#include "render_stats.h"
 
 class window : public canvas_window {
 public:
@@ -69,6 +70,10 @@ private:
 
     ref::node* m_tree;
 
+    // the counters are updated by the window's thread and read or
+    // reset by the Lua thread, both with the window's lock held
+    render_stats m_stats;
+
 public:
     window(gsl_shell_state* gs, agg::rgba8 bgcol= colors::white):
         canvas_window(gs, bgcol), m_tree(0)
@@ -91,6 +96,9 @@ public:
 
     void draw_slot(int slot_id);
 
+    const render_stats& stats() const { return m_stats; }
+    void reset_stats() { m_stats.reset(); }
+
     virtual void on_draw();
     virtual void on_resize(int sx, int sy);
 
@@ -16,12 +16,15 @@ extern "C" {
 #include "split-parser.h"
 #include "lua-utils.h"
 #include "platform_support_ext.h"
+#include "profiler.h"
 
 __BEGIN_DECLS
 
 static int window_free            (lua_State *L);
 static int window_split           (lua_State *L);
 static int window_save_svg        (lua_State *L);
+static int window_stats           (lua_State *L);
+static int window_reset_stats     (lua_State *L);
 
 static const struct luaL_Reg window_functions[] = {
     {"window",        window_new},
@@ -35,6 +38,8 @@ static const struct luaL_Reg window_methods[] = {
     {"update",         window_update        },
     {"close",          window_close         },
     {"save_svg",       window_save_svg      },
+    {"stats",          window_stats         },
+    {"reset_stats",    window_reset_stats   },
     {"__gc",           window_free          },
     {NULL, NULL}
 };
@@ -127,6 +132,7 @@ window::ref* window::ref_lookup (ref::node *p, int slot_id)
 
 void window::draw_slot_by_ref(window::ref& ref, bool draw_image)
 {
+    profiler_zone_scope zone(PROFILER_ZONE_AGG);
     agg::trans_affine mtx(ref.matrix);
     this->scale(mtx);
 
@@ -135,13 +141,21 @@ void window::draw_slot_by_ref(window::ref& ref, bool draw_image)
 
     if (ref.plot)
     {
-        AGG_LOCK();
+        {
+            render_timer timer(m_stats.time[render_stats::lock_wait]);
+            AGG_LOCK();
+        }
+        render_stats before = ref.plot->stats();
         ref.plot->draw(*m_canvas, mtx, &ref.inf);
+        m_stats.add_delta(before, ref.plot->stats());
         AGG_UNLOCK();
     }
 
     if (draw_image)
+    {
+        render_timer timer(m_stats.time[render_stats::blit]);
         update_region(r);
+    }
 }
 
 void
@@ -206,6 +220,7 @@ window::restore_slot_image(int slot_id)
 void
 window::refresh_slot_by_ref(ref& ref, bool draw_all)
 {
+    profiler_zone_scope zone(PROFILER_ZONE_AGG);
     agg::trans_affine mtx(ref.matrix);
     this->scale(mtx);
 
@@ -214,9 +229,14 @@ window::refresh_slot_by_ref(ref& ref, bool draw_all)
     if (!ref.valid_rect || draw_all)
         rect.set(rect_of_slot_matrix<double>(mtx));
 
-    AGG_LOCK();
+    {
+        render_timer timer(m_stats.time[render_stats::lock_wait]);
+        AGG_LOCK();
+    }
     opt_rect<double> draw_rect;
+    render_stats before = ref.plot->stats();
     ref.plot->draw_queue(*m_canvas, mtx, ref.inf, draw_rect);
+    m_stats.add_delta(before, ref.plot->stats());
     rect.add<rect_union>(draw_rect);
     rect.add<rect_union>(ref.dirty_rect);
     ref.dirty_rect = draw_rect;
@@ -227,6 +247,7 @@ window::refresh_slot_by_ref(ref& ref, bool draw_all)
         const int m = 4;
         const agg::rect_base<double>& r = rect.rect();
         const agg::rect_base<int> ri(r.x1 - m, r.y1 - m, r.x2 + m, r.y2 + m);
+        render_timer timer(m_stats.time[render_stats::blit]);
         update_region (ri);
     }
 }
@@ -589,8 +610,8 @@ window_wait (lua_State *L)
 
 class svg_writer {
 public:
-    svg_writer(FILE* f, double w, double h):
-    m_canvas(f, h), m_width(w), m_height(h)
+    svg_writer(FILE* f, double w, double h, const svg_stream::options& opt):
+    m_canvas(f, h, opt), m_width(w), m_height(h)
     { }
 
     void write_header() { m_canvas.write_header(m_width, m_height); }
@@ -624,9 +645,12 @@ window_save_svg_try(lua_State *L)
     const char *filename = lua_tostring(L, 2);
     const double w = luaL_optnumber(L, 3, 600.0);
     const double h = luaL_optnumber(L, 4, 600.0);
+    svg_stream::options opt;
 
     if (!filename) return type_error_return(L, 2, "string");
 
+    svg_options_lookup(L, 5, opt);
+
     unsigned fnlen = strlen(filename);
     if (fnlen <= 4 || strcmp(filename + (fnlen - 4), ".svg") != 0)
     {
@@ -642,7 +666,7 @@ window_save_svg_try(lua_State *L)
         return (-1);
     }
 
-    svg_writer svg_writer(f, w, h);
+    svg_writer svg_writer(f, w, h, opt);
     svg_writer.write_header();
     win->plot_apply(svg_writer);
     svg_writer.write_end();
@@ -659,6 +683,30 @@ window_save_svg(lua_State *L)
     return nret;
 }
 
+int
+window_stats (lua_State *L)
+{
+    window *win = object_check<window>(L, 1, GS_WINDOW);
+    win->lock();
+    render_stats st = win->stats();
+    win->unlock();
+    render_stats_push(L, st);
+    return 1;
+}
+
+int
+window_reset_stats (lua_State *L)
+{
+    window *win = object_check<window>(L, 1, GS_WINDOW);
+    AGG_LOCK();
+    render_stats_vertices = true;
+    AGG_UNLOCK();
+    win->lock();
+    win->reset_stats();
+    win->unlock();
+    return 0;
+}
+
 void
 window_register (lua_State *L)
 {
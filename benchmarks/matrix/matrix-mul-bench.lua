@@ -0,0 +1,56 @@
+-- matrix-mul-bench.lua
+--
+-- Benchmark of the matrix products with each available BLAS backend.
+-- Each case multiplies two random matrices a given number of times.
+-- The shapes are a square product, a tall-skinny product like X^T X
+-- and a model matrix times a coefficients vector. The results are
+-- printed in the format of benchmarks/results.csv with the rate in
+-- GFlops as an additional column.
+--
+-- Usage: gsl-shell matrix-mul-bench.lua [backend ...]
+--
+-- The backends are "gsl", "native" or the names of CBLAS libraries
+-- like "openblas". By default all the ones that can be loaded are used.
+
+local time = require 'time'
+
+local backends = (arg and #arg > 0) and arg or {'gsl', 'native', 'openblas', 'blis', 'mkl_rt'}
+
+local cases = {
+   {name= 'square 500',      n1= 500,    n2= 500, n3= 500, repeats= 4},
+   {name= 'tall-skinny XtX', n1= 50,     n2= 50,  n3= 20000, repeats= 4, transpose= true},
+   {name= 'model X * c',     n1= 100000, n2= 1,   n3= 20,  repeats= 40},
+   {name= 'complex 200',     n1= 200,    n2= 200, n3= 200, repeats= 4, complex= true},
+}
+
+local function random_matrix(r, n, m, complex)
+   if complex then
+      return matrix.cnew(n, m, |i,j| r:get() - 0.5 + (r:get() - 0.5)*1i)
+   else
+      return matrix.new(n, m, |i,j| r:get() - 0.5)
+   end
+end
+
+local r = rng.new()
+local operands = {}
+for k, case in ipairs(cases) do
+   local a = random_matrix(r, case.n3, case.n1, case.complex)
+   if not case.transpose then a = random_matrix(r, case.n1, case.n3, case.complex) end
+   local b = random_matrix(r, case.n3, case.n2, case.complex)
+   operands[k] = {a= case.transpose and matrix.transpose(a) or a, b= b}
+end
+
+print('Test,Source,Time,GFlops')
+for _, name in ipairs(backends) do
+   if pcall(matrix.set_blas, name) then
+      for k, case in ipairs(cases) do
+         local a, b = operands[k].a, operands[k].b
+         local c = a * b
+         local t0 = time.ms()
+         for i = 1, case.repeats do c = a * b end
+         local t = (time.ms() - t0) / 1000 / case.repeats
+         local flops = 2 * case.n1 * case.n2 * case.n3 * (case.complex and 4 or 1)
+         print(string.format('%s,%s,%.4f,%.2f', case.name, name, t, flops / t * 1e-9))
+      end
+   end
+end
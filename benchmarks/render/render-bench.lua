@@ -0,0 +1,171 @@
+-- render-bench.lua
+--
+-- Benchmark of the plot rendering pipeline. Each scene builds a plot
+-- and renders it a given number of times in an offscreen image, so
+-- that no window is needed. The results are printed in the format of
+-- benchmarks/results.csv. The number of graphical items rendered per
+-- second and the peak memory of each scene in MB are reported
+-- separately on the standard error. The peak memory is only available
+-- on Linux.
+--
+-- Usage: gsl-shell render-bench.lua [source-label] [output.csv]
+
+local time = require 'time'
+
+local source = arg and arg[1] or 'LuaJIT2'
+local output = arg and arg[2]
+
+local W, H = 800, 600
+local tmpname = os.tmpname()
+
+local sin, cos, pi, random = math.sin, math.cos, math.pi, math.random
+
+-- Reset the peak resident memory of the process so that each scene
+-- reports its own peak. Only available on Linux, where writing 5 to
+-- /proc/self/clear_refs resets the VmHWM value.
+local function reset_peak_memory()
+   local f = io.open('/proc/self/clear_refs', 'w')
+   if not f then return false end
+   local ok = f:write('5')
+   f:close()
+   return ok and true or false
+end
+
+-- peak resident memory in MB from /proc, only available on Linux
+local function peak_memory()
+   local f = io.open('/proc/self/status')
+   if not f then return nil end
+   local s = f:read('*a')
+   f:close()
+   local kb = s:match('VmHWM:%s*(%d+)')
+   return kb and tonumber(kb) / 1024
+end
+
+local function long_line(n)
+   local ln = graph.path(0, 0)
+   for k = 1, n - 1 do
+      local x = 10 * k / n
+      ln:line_to(x, sin(20 * x) * cos(3 * x))
+   end
+   return ln
+end
+
+local scenes = {
+   {name = 'Render line 1e6 vertices', frames = 5, items = 1e6,
+    setup = function()
+       local p = graph.plot('Line')
+       p:addline(long_line(1e6), 'blue')
+       return p
+    end},
+
+   {name = 'Render line 1e7 vertices', frames = 1, items = 1e7,
+    setup = function()
+       local p = graph.plot('Line')
+       p:addline(long_line(1e7), 'blue')
+       return p
+    end},
+
+   {name = 'Render markers', frames = 5, items = 2e4,
+    setup = function()
+       local p = graph.plot('Markers')
+       for k = 1, 2e4 do
+          p:add(graph.marker(random(), random(), 'circle', 6), 'red')
+       end
+       return p
+    end},
+
+   {name = 'Render small items', frames = 5, items = 2e4,
+    setup = function()
+       local p = graph.plot('Small items')
+       for k = 1, 2e4 do
+          local x, y = random(), random()
+          p:add(graph.rect(x, y, x + 0.005, y + 0.005), 'darkgreen')
+       end
+       return p
+    end},
+
+   {name = 'Render text axis', frames = 20, items = 200,
+    setup = function()
+       local p = graph.plot('Labels')
+       local cat = {}
+       for k = 1, 200 do
+          cat[#cat+1] = k
+          cat[#cat+1] = string.format('label %i', k)
+       end
+       p:set_categories('x', cat)
+       p.xlab_angle = pi / 4
+       p:addline(graph.fxline(|x| sin(x / 10), 1, 200), 'blue')
+       return p
+    end},
+
+   {name = 'Render contour', frames = 5, items = 1,
+    setup = function()
+       local f = |x, y| sin(x) * cos(y) + 0.1 * x
+       return contour.plot(f, -4, -4, 4, 4, {gridx = 80, gridy = 80, levels = 20, show = false})
+    end},
+
+   {name = 'Render animation layers', frames = 50, items = 1,
+    setup = function()
+       local p = graph.plot('Animation')
+       p.sync = false
+       p:addline(long_line(1e4), 'gray')
+       p:pushlayer()
+       return p
+    end,
+    frame = function(p, k)
+       p:clear()
+       local x = k / 50 * 10
+       p:add(graph.circle(x, 0, 0.2), 'red')
+       p:flush()
+       p:save(tmpname, W, H)
+    end},
+
+   {name = 'Render SVG export', frames = 5, items = 1e5,
+    setup = function()
+       local p = graph.plot('SVG')
+       p:addline(long_line(1e5), 'blue')
+       return p
+    end,
+    frame = function(p)
+       p:save_svg(tmpname, W, H)
+    end},
+}
+
+local function default_frame(p)
+   p:save(tmpname, W, H)
+end
+
+local lines = {}
+
+local function report(name, t, rate, mem)
+   local line = string.format('%s,%s,%.4f', name, source, t)
+   print(line)
+   lines[#lines+1] = line
+   local mem_str = mem and string.format('%.1f MB', mem) or 'n/a'
+   io.stderr:write(string.format('%s: %.1f items/s, peak memory %s\n', name, rate, mem_str))
+end
+
+print('Test,Source,Time')
+for _, scene in ipairs(scenes) do
+   collectgarbage()
+   local mem_reset = reset_peak_memory()
+   local p = scene.setup()
+   local frame = scene.frame or default_frame
+   collectgarbage()
+   local t0 = time.ms()
+   for k = 1, scene.frames do frame(p, k) end
+   local t = (time.ms() - t0) / 1000 / scene.frames
+   -- the peak is not reported if it could not be reset
+   report(scene.name, t, scene.items / t, mem_reset and peak_memory())
+end
+
+os.remove(tmpname)
+os.remove(tmpname .. '.ppm')
+os.remove(tmpname .. '.bmp')
+os.remove(tmpname .. '.svg')
+
+if output then
+   local f = assert(io.open(output, 'a'))
+   for _, line in ipairs(lines) do f:write(line, '\n') end
+   f:close()
+end
@@ -20,6 +20,9 @@ local s = roots.solver(f, 1e-8, 1e-6, f_scale)
 local x1, x2 = 0, 1000000
 local rs = s:solve(x1, x2)
 
+-- Sampling on a grid finer than the distance between the roots
+-- local rs = s:solve_grid(x1, x2, 1000000)
+
 print(string.format('Found %d roots in the interval %f %f.', #rs, x1, x2))
 
 for k=1, 10 do print(rs[k]) end
@@ -0,0 +1,38 @@
+#!/bin/sh
+#
+# Measure the startup time of GSL Shell. Each test runs the given Lua
+# chunk N times in a new gsl-shell process and reports the average
+# wall time in milliseconds in the format of benchmarks/results.csv.
+#
+# Usage: startup-bench.sh [N]
+#
+# The executable can be given with the GSL_SHELL environment variable
+# and the label of the results with SOURCE (for example "bundle").
+
+GSL_SHELL=${GSL_SHELL:-../../gsl-shell}
+SOURCE=${SOURCE:-default}
+N=${1:-50}
+
+now() {
+    date +%s%N
+}
+
+run_test() {
+    name=$1
+    chunk=$2
+    start=`now`
+    i=0
+    while [ $i -lt $N ]; do
+        $GSL_SHELL -e "$chunk" > /dev/null || exit 1
+        i=`expr $i + 1`
+    done
+    stop=`now`
+    echo "$name,$SOURCE,`echo "($stop - $start) / ($N * 1000000)" | bc -l | cut -c1-6`"
+}
+
+echo "Test,Source,Time"
+run_test "Startup empty" ""
+run_test "Startup matrix" "local m = matrix.new(3, 3)"
+run_test "Startup num" "local x = num.integ(math.sin, 0, 1)"
+run_test "Startup gdt" "local t = gdt.alloc(3, {'x', 'y'})"
+run_test "Startup all" "local a, b, c, d = matrix, num, gdt, eigen"
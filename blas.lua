@@ -0,0 +1,147 @@
+-- Backends for the matrix products. A backend can be the GSL BLAS
+-- functions, an optimized CBLAS library loaded at runtime or the
+-- blocked products built in GSL Shell. The backend is selected with
+-- the environment variable GSL_SHELL_BLAS or with matrix.set_blas().
+
+local ffi = require 'ffi'
+local gsl = require 'gsl'
+local gsl_check = require 'gsl-check'
+
+ffi.cdef[[
+void cblas_dgemm(const enum CBLAS_ORDER Order, const enum CBLAS_TRANSPOSE TransA,
+                 const enum CBLAS_TRANSPOSE TransB, const int M, const int N,
+                 const int K, const double alpha, const double *A,
+                 const int lda, const double *B, const int ldb,
+                 const double beta, double *C, const int ldc);
+void cblas_zgemm(const enum CBLAS_ORDER Order, const enum CBLAS_TRANSPOSE TransA,
+                 const enum CBLAS_TRANSPOSE TransB, const int M, const int N,
+                 const int K, const void *alpha, const void *A,
+                 const int lda, const void *B, const int ldb,
+                 const void *beta, void *C, const int ldc);
+
+void gs_dgemm (int m, int n, int k, const double *a, int lda,
+               const double *b, int ldb, double *c, int ldc, int nthreads);
+void gs_zgemm (int m, int n, int k, const double *a, int lda,
+               const double *b, int ldb, double *c, int ldc, int nthreads);
+]]
+
+local NT, ROW_MAJOR = gsl.CblasNoTrans, gsl.CblasRowMajor
+
+-- optimized libraries searched when no backend is given
+local cblas_libraries = {'openblas', 'blis', 'mkl_rt'}
+
+local function gsl_backend()
+   return {
+      name = 'gsl',
+      dgemm = function(a, b, c)
+                 gsl_check(gsl.gsl_blas_dgemm(NT, NT, 1, a, b, 0, c))
+              end,
+      zgemm = function(a, b, c)
+                 gsl_check(gsl.gsl_blas_zgemm(NT, NT, 1, a, b, 0, c))
+              end,
+   }
+end
+
+local function native_backend(nthreads)
+   local C = ffi.C
+   if not pcall(function() return C.gs_dgemm end) then return end
+   nthreads = nthreads or tonumber(os.getenv('GSL_SHELL_BLAS_THREADS')) or 0
+   return {
+      name = 'native',
+      dgemm = function(a, b, c)
+                 C.gs_dgemm(c.size1, c.size2, a.size2, a.data, a.tda,
+                            b.data, b.tda, c.data, c.tda, nthreads)
+              end,
+      zgemm = function(a, b, c)
+                 C.gs_zgemm(c.size1, c.size2, a.size2, a.data, a.tda,
+                            b.data, b.tda, c.data, c.tda, nthreads)
+              end,
+   }
+end
+
+local function cblas_backend(name)
+   local ok, lib = pcall(ffi.load, name)
+   if not ok or not pcall(function() return lib.cblas_dgemm, lib.cblas_zgemm end) then
+      return
+   end
+   local one, zero = ffi.new('double[2]', 1, 0), ffi.new('double[2]', 0, 0)
+   return {
+      name = name,
+      lib = lib,
+      dgemm = function(a, b, c)
+                 lib.cblas_dgemm(ROW_MAJOR, NT, NT, c.size1, c.size2, a.size2,
+                                 1, a.data, a.tda, b.data, b.tda, 0, c.data, c.tda)
+              end,
+      zgemm = function(a, b, c)
+                 lib.cblas_zgemm(ROW_MAJOR, NT, NT, c.size1, c.size2, a.size2,
+                                 one, a.data, a.tda, b.data, b.tda, zero, c.data, c.tda)
+              end,
+   }
+end
+
+local function find_backend(name, nthreads)
+   if name == 'gsl' then
+      return gsl_backend()
+   elseif name == 'native' then
+      return native_backend(nthreads)
+   else
+      return cblas_backend(name)
+   end
+end
+
+local function default_backend()
+   local name = os.getenv('GSL_SHELL_BLAS')
+   if name then
+      local b = find_backend(name)
+      if b then return b end
+      io.stderr:write(string.format('warning: cannot load the BLAS backend "%s"\n', name))
+   else
+      for _, lib_name in ipairs(cblas_libraries) do
+         local b = cblas_backend(lib_name)
+         if b then return b end
+      end
+   end
+   return native_backend() or gsl_backend()
+end
+
+-- the default backend is searched at the first product so that the
+-- libraries are not loaded at startup
+local backend
+
+local blas = {}
+
+-- Select the backend by name: "gsl", "native" or the name of a CBLAS
+-- library. The number of threads is used by the native backend, the
+-- libraries have their own settings. Return the name of the backend.
+function blas.select(name, nthreads)
+   local b = find_backend(name, nthreads)
+   if not b then error(string.format('cannot load the BLAS backend "%s"', name), 2) end
+   backend = b
+   return b.name
+end
+
+function blas.name()
+   backend = backend or default_backend()
+   return backend.name
+end
+
+-- c = a * b, the dimensions of c should be already set
+local function check_dims(a, b, c)
+   if a.size2 ~= b.size1 or c.size1 ~= a.size1 or c.size2 ~= b.size2 then
+      gsl_check(gsl.GSL_EBADLEN)
+   end
+end
+
+function blas.dgemm(a, b, c)
+   check_dims(a, b, c)
+   backend = backend or default_backend()
+   backend.dgemm(a, b, c)
+end
+
+function blas.zgemm(a, b, c)
+   check_dims(a, b, c)
+   backend = backend or default_backend()
+   backend.zgemm(a, b, c)
+end
+
+return blas
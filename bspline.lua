@@ -1,9 +1,19 @@
-
 local ffi = require 'ffi'
 local gsl = require 'gsl'
 
 local gsl_check = require 'gsl-check'
 
+local sqrt = math.sqrt
+
+-- evaluate the nonzero basis functions at x in the k elements of the
+-- array "row" and return the index of the first one
+local function eval_row(bs, x, row)
+   local bk, istart, iend = bs.bk, bs.istart, bs.iend
+   bk.data = row
+   gsl_check(gsl.gsl_bspline_eval_nonzero(x, bk, istart, iend, bs.ws))
+   return tonumber(istart[0])
+end
+
 local function eval(bs, x)
    local dof, ws = bs.dof, bs.ws
    local c = matrix.alloc(dof, 1)
@@ -13,19 +23,171 @@ local function eval(bs, x)
 end
 
 local function model(bs, x)
-   local dof, ws = bs.dof, bs.ws
+   local dof, k = bs.dof, bs.k
+   local n = matrix.dim(x)
+   local m = matrix.new(n, dof)
+   local row = bs.row
+   for j = 0, n-1 do
+      local xj = gsl.gsl_matrix_get(x, j, 0)
+      local i0 = eval_row(bs, xj, row)
+      local mrow = m.data + j * m.tda + i0
+      for i = 0, k-1 do mrow[i] = row[i] end
+   end
+   return m
+end
+
+-- A banded model matrix stores, for each row, the index of its first
+-- nonzero column and the k values starting from it.
+local Band = {}
+Band.__index = Band
+
+local function model_band(bs, x)
+   local dof, k = bs.dof, bs.k
    local n = matrix.dim(x)
-   local m = matrix.alloc(n, dof)
+   local values = matrix.alloc(n, k)
+   local first = ffi.new('int32_t[?]', n)
    for j = 0, n-1 do
       local xj = gsl.gsl_matrix_get(x, j, 0)
-      local v = gsl.gsl_matrix_row (m, j)
-      gsl_check(gsl.gsl_bspline_eval(xj, v, ws))
+      first[j] = eval_row(bs, xj, values.data + j * k)
+   end
+   local X = {n= n, dof= dof, k= k, first= first, values= values}
+   return setmetatable(X, Band)
+end
+
+-- return the product of the model matrix with the column matrix c
+function Band.mul(X, c)
+   local n, k, first = X.n, X.k, X.first
+   local v, cd = X.values.data, c.data
+   local y = matrix.alloc(n, 1)
+   for j = 0, n-1 do
+      local i0, s = first[j], 0
+      for i = 0, k-1 do s = s + v[j*k+i] * cd[(i0+i)*c.tda] end
+      y.data[j] = s
+   end
+   return y
+end
+
+function Band.dense(X)
+   local n, k, dof, first = X.n, X.k, X.dof, X.first
+   local m = matrix.new(n, dof)
+   for j = 0, n-1 do
+      local mrow = m.data + j * m.tda + first[j]
+      for i = 0, k-1 do mrow[i] = X.values.data[j*k+i] end
    end
    return m
 end
 
+-- Cholesky factorization A = U^T U of a symmetric positive definite
+-- band matrix. Both A and U are stored as matrices with k columns with
+-- the element (i, i+d) in the row i, column d.
+local function band_cholesky(a, n, k)
+   local ad = a.data
+   for i = 0, n-1 do
+      for d = 0, k-1 do
+         local j = i + d
+         if j >= n then break end
+         local s = ad[i*k+d]
+         for l = math.max(0, j-k+1), i-1 do
+            s = s - ad[l*k+i-l] * ad[l*k+j-l]
+         end
+         if d == 0 then
+            if s <= 0 then
+               error('singular normal equations: not enough data in the knots intervals', 3)
+            end
+            ad[i*k] = sqrt(s)
+         else
+            ad[i*k+d] = s / ad[i*k]
+         end
+      end
+   end
+end
+
+-- solve U^T U x = b in place for the factor given by band_cholesky
+local function band_solve(u, n, k, b, stride)
+   local ud = u.data
+   for i = 0, n-1 do
+      local s = b[i*stride]
+      for l = math.max(0, i-k+1), i-1 do s = s - ud[l*k+i-l] * b[l*stride] end
+      b[i*stride] = s / ud[i*k]
+   end
+   for i = n-1, 0, -1 do
+      local s = b[i*stride]
+      for d = 1, math.min(k-1, n-1-i) do s = s - ud[i*k+d] * b[(i+d)*stride] end
+      b[i*stride] = s / ud[i*k]
+   end
+end
+
+-- Least squares fit using the normal equations. The matrix X^T W X is
+-- a band matrix with k-1 diagonals above the main one so it can be
+-- factorized with O(dof k^2) operations. Return the coefficients, the
+-- chi square and the covariance matrix of the coefficients.
+function Band.linfit(X, y, w)
+   local n, k, dof, first = X.n, X.k, X.dof, X.first
+   local v = X.values.data
+   local a = matrix.new(dof, k)
+   local c = matrix.new(dof, 1)
+   local ad, cd = a.data, c.data
+   for j = 0, n-1 do
+      local i0 = first[j]
+      local wj = w and w.data[j*w.tda] or 1
+      local yj = y.data[j*y.tda]
+      for p = 0, k-1 do
+         local bp = wj * v[j*k+p]
+         cd[i0+p] = cd[i0+p] + bp * yj
+         for q = p, k-1 do
+            ad[(i0+p)*k+q-p] = ad[(i0+p)*k+q-p] + bp * v[j*k+q]
+         end
+      end
+   end
+
+   band_cholesky(a, dof, k)
+   band_solve(a, dof, k, cd, 1)
+
+   local chisq = 0
+   for j = 0, n-1 do
+      local i0, s = first[j], 0
+      for i = 0, k-1 do s = s + v[j*k+i] * cd[i0+i] end
+      local r = y.data[j*y.tda] - s
+      chisq = chisq + (w and w.data[j*w.tda] or 1) * r^2
+   end
+
+   local cov = matrix.unit(dof)
+   for i = 0, dof-1 do
+      band_solve(a, dof, k, cov.data + i, cov.tda)
+   end
+
+   -- without weights the variance of the data is estimated from the
+   -- residuals like in gsl_multifit_linear
+   if not w then
+      local s2 = chisq / (n - dof)
+      for i = 0, dof-1 do
+         for j = 0, dof-1 do
+            cov.data[i*cov.tda+j] = s2 * cov.data[i*cov.tda+j]
+         end
+      end
+   end
+
+   return c, chisq, cov
+end
+
+-- evaluate the spline with coefficients c at each point of the
+-- column matrix x
+local function eval_many(bs, x, c)
+   local k = bs.k
+   local n = matrix.dim(x)
+   local y = matrix.alloc(n, 1)
+   local row, cd = bs.row, c.data
+   for j = 0, n-1 do
+      local i0 = eval_row(bs, gsl.gsl_matrix_get(x, j, 0), row)
+      local s = 0
+      for i = 0, k-1 do s = s + row[i] * cd[(i0+i)*c.tda] end
+      y.data[j] = s
+   end
+   return y
+end
+
 local mt = {
-   __index = {eval= eval, model= model}
+   __index = {eval= eval, model= model, model_band= model_band, eval_many= eval_many}
 }
 
 local function bspline(a, b, nbreak)
@@ -47,7 +209,12 @@ local function bspline(a, b, nbreak)
       gsl_check(gsl.gsl_bspline_knots_uniform (a, b, ws))
    end
 
-   local bs = {dof= dof, ws= ws}
+   -- vector used to evaluate the nonzero basis functions
+   local row = ffi.new('double[?]', k)
+   local bk = ffi.new('gsl_vector', {size= k, stride= 1, data= row, block= nil, owner= 0})
+
+   local bs = {dof= dof, k= k, ws= ws, row= row, bk= bk,
+               istart= ffi.new('size_t[1]'), iend= ffi.new('size_t[1]')}
    setmetatable(bs, mt)
 
    return bs
@@ -22,15 +22,70 @@ void initialize_readline()
 
 #define WORDS_BUFFER_SIZE 256
 #define NODE_LIST_SIZE 8
+
+/* Return the next key of the table on top of the stack that begins
+   with "text_term", skipping the first "*index" keys. The table is
+   popped from the stack. If "is_autoload" is true the keys are the
+   names of the globals not yet loaded and their type is unknown. */
+static char *
+table_next_match (lua_State *L, int *index, const char *base_word,
+                  const char *text_term, int len, int is_autoload)
+{
+    int k;
+
+    lua_pushnil (L);
+    for (k = 0; k < *index; k++)
+    {
+        if (lua_next (L, -2) == 0)
+            goto pop_exit;
+        lua_pop (L, 1);
+    }
+
+    while (lua_next(L, -2) != 0)
+    {
+        const char *key = lua_tostring (L, -2);
+
+        (*index) ++;
+
+        if (key)
+        {
+            if (strncmp (key, text_term, len) == 0)
+            {
+                char *new_word;
+
+                if (lua_istable (L, -1) && !is_autoload)
+                    rl_completion_append_character = '.';
+                else
+                    rl_completion_suppress_append = 1;
+
+                if (asprintf (&new_word, "%s%s", base_word, key) < 0)
+                {
+                    lua_pop (L, 2);
+                    goto pop_exit;
+                }
+
+                lua_pop (L, 3);
+                return new_word;
+            }
+        }
+
+        lua_pop (L, 1);
+    }
+
+pop_exit:
+    lua_pop (L, 1);
+    return NULL;
+}
+
 char *my_generator (const char *text, int state)
 {
-    static int list_index, len;
+    static int list_index, autoload_index, len;
     static const char *text_term;
     static char words_buffer[WORDS_BUFFER_SIZE];
     static char *node_list[NODE_LIST_SIZE];
     static int word_number;
     static char *base_word;
-    char *word;
+    char *word, *match;
     lua_State *L = globalL;
     int k;
 
@@ -40,6 +95,7 @@ char *my_generator (const char *text, int state)
         int node_counter = 0, words_index = 0;
 
         list_index = 0;
+        autoload_index = 0;
         word_number = 0;
 
         if (strlen (text) >= WORDS_BUFFER_SIZE)
@@ -94,45 +150,21 @@ char *my_generator (const char *text, int state)
     if (!lua_istable(L, -1))
         goto pop_exit;
 
-    lua_pushnil (L);
-    for (k = 0; k < list_index; k++)
-    {
-        if (lua_next (L, -2) == 0)
-            goto pop_exit;
-        lua_pop (L, 1);
-    }
+    match = table_next_match (L, &list_index, base_word, text_term, len, 0);
+    if (match || word_number > 0)
+        return match;
 
-    while (lua_next(L, -2) != 0)
+    /* the globals loaded on demand by gslext.lua are not yet in the
+       globals table but they are listed in the registry */
+    lua_getfield (L, LUA_REGISTRYINDEX, "__gsl_autoload");
+    if (!lua_istable(L, -1))
     {
-        const char *key = lua_tostring (L, -2);
-
-        list_index ++;
-
-        if (key)
-        {
-            if (strncmp (key, text_term, len) == 0)
-            {
-                char *new_word;
-
-                if (lua_istable (L, -1))
-                    rl_completion_append_character = '.';
-                else
-                    rl_completion_suppress_append = 1;
-
-                if (asprintf (&new_word, "%s%s", base_word, key) < 0)
-                {
-                    lua_pop (L, 2);
-                    goto pop_exit;
-                }
-
-                lua_pop (L, 3);
-                return new_word;
-            }
-        }
-
         lua_pop (L, 1);
+        return NULL;
     }
 
+    return table_next_match (L, &autoload_index, base_word, text_term, len, 1);
+
 pop_exit:
     lua_pop (L, 1);
     return NULL;
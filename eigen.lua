@@ -342,6 +342,36 @@ local function get_order(order)
    return sel
 end
 
+-- The workspaces are kept for reuse in a small cache for each kind,
+-- indexed by size. The most recently used workspace is at the front
+-- of the list and the last one is dropped when the list is full.
+local workspace_max = 4
+local workspaces = {}
+
+local function workspace(kind, size)
+   local cache = workspaces[kind]
+   if not cache then
+      cache = {}
+      workspaces[kind] = cache
+   end
+   local n = tonumber(size)
+   for k, ws in ipairs(cache) do
+      if ws.n == n then
+         -- move the workspace to the front of the list
+         table.remove(cache, k)
+         table.insert(cache, 1, ws)
+         return ws.w
+      end
+   end
+   local alloc, free = gsl['gsl_eigen_' .. kind .. '_alloc'], gsl['gsl_eigen_' .. kind .. '_free']
+   local ws = {n = n, w = ffi.gc(alloc(n), free)}
+   table.insert(cache, 1, ws)
+   if #cache > workspace_max then
+      cache[#cache] = nil
+   end
+   return ws.w
+end
+
 --Calculates the eigenvalues/eigenvectors of the symmetric matrix m
 --the order can be used to determine the sorting of the eigenvalues according to their value
 function eigen.symm(m, order)
@@ -352,9 +382,8 @@ function eigen.symm(m, order)
    local xeval = gsl.gsl_matrix_column(eval, 0)
    local order_sel = get_order(order)
 
-   local w = gsl.gsl_eigen_symmv_alloc (size)
+   local w = workspace('symmv', size)
    gsl_check(gsl.gsl_eigen_symmv (A, xeval, evec, w))
-   gsl.gsl_eigen_symmv_free (w)
 
    if order_sel ~= SORT_NONE then
       gsl.gsl_eigen_symmv_sort (xeval, evec, order_sel)
@@ -373,9 +402,8 @@ function eigen.non_symm(m, order)
    local xeval = gsl.gsl_matrix_complex_column(eval, 0)
    local order_sel = get_order(order)
 
-   local w = gsl.gsl_eigen_nonsymmv_alloc (size)
+   local w = workspace('nonsymmv', size)
    gsl_check(gsl.gsl_eigen_nonsymmv (A, xeval, evec, w))
-   gsl.gsl_eigen_nonsymmv_free (w)
 
    if order_sel ~= SORT_NONE then
       gsl.gsl_eigen_nonsymmv_sort (xeval, evec, order_sel)
@@ -392,9 +420,8 @@ function eigen.herm(m, order, eigenvalues_only)
    local evec = matrix.calloc (size, size)
    local order_sel = get_order(order)
 
-   local w = gsl.gsl_eigen_hermv_alloc (size)
+   local w = workspace('hermv', size)
    gsl_check(gsl.gsl_eigen_hermv(A, xeval, evec, w))
-   gsl.gsl_eigen_hermv_free (w)
 
    if order_sel ~= SORT_NONE then
       gsl.gsl_eigen_hermv_sort (xeval, evec, order_sel)
@@ -413,9 +440,8 @@ function eigen.gensymm(a, b)
    local evec = matrix.alloc (size, size)
    local order_sel = get_order(order)
 
-   local w = gsl.gsl_eigen_gensymmv_alloc (size)
+   local w = workspace('gensymmv', size)
    gsl_check(gsl.gsl_eigen_gensymmv(A,B, xeval, evec, w))
-   gsl.gsl_eigen_gensymmv_free (w)
 
    if order_sel ~= SORT_NONE then
       gsl.gsl_eigen_gensymmv_sort (xeval, evec, order_sel)
@@ -433,9 +459,8 @@ function eigen.genherm(a, b)
    local evec = matrix.calloc (size, size)
    local order_sel = get_order(order)
 
-   local w = gsl.gsl_eigen_genhermv_alloc (size)
+   local w = workspace('genhermv', size)
    gsl_check(gsl.gsl_eigen_genhermv(A,B, xeval, evec, w))
-   gsl.gsl_eigen_genhermv_free (w)
 
    if order_sel ~= SORT_NONE then
       gsl.gsl_eigen_genhermv_sort (xeval, evec, order_sel)
@@ -457,9 +482,8 @@ function eigen.gen(a, b)
    local evec = matrix.calloc (size, size)
    local order_sel = get_order(order)
 
-   local w = gsl.gsl_eigen_genv_alloc (size)
+   local w = workspace('genv', size)
    gsl_check(gsl.gsl_eigen_genv(A,B, alpha_vec, beta_vec, evec, w))
-   gsl.gsl_eigen_genv_free (w)
 
    if order_sel ~= SORT_NONE then
       gsl.gsl_eigen_genv_sort (alpha_vec, beta_vec, evec, order_sel)
@@ -467,3 +491,36 @@ function eigen.gen(a, b)
 
    return alpha, beta, evec
 end
+
+--Calculates the eigenvalues/eigenvectors of k symmetric matrices of
+--size n stacked by rows in the (k n) x n matrix "stack". Return a k x n
+--matrix with the eigenvalues of each matrix in a row and a (k n) x n
+--matrix with the eigenvectors stacked like the input.
+function eigen.symm_many(stack, n, order)
+   local rows = tonumber(stack.size1)
+   if stack.size2 ~= n or rows % n ~= 0 then
+      error(format('expecting a stack of %d x %d matrices', n, n), 2)
+   end
+   local k = rows / n
+   local order_sel = get_order(order)
+   local evals = matrix.alloc(k, n)
+   local evecs = matrix.alloc(rows, n)
+   local A = matrix.alloc(n, n)
+   local w = workspace('symmv', n)
+
+   local src = ffi.new('gsl_matrix', {size1= n, size2= n, tda= stack.tda})
+   local evec = ffi.new('gsl_matrix', {size1= n, size2= n, tda= n})
+   local eval = ffi.new('gsl_vector', {size= n, stride= 1})
+   for j = 0, k-1 do
+      src.data = stack.data + j * n * stack.tda
+      evec.data = evecs.data + j * n * n
+      eval.data = evals.data + j * n
+      gsl.gsl_matrix_memcpy(A, src)
+      gsl_check(gsl.gsl_eigen_symmv (A, eval, evec, w))
+      if order_sel ~= SORT_NONE then
+         gsl.gsl_eigen_symmv_sort (eval, evec, order_sel)
+      end
+   end
+
+   return evals, evecs
+end
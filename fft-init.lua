@@ -96,8 +96,12 @@ local function is_two_power(n)
    end
 end
 
-local cache_n = {}
-local cache_r = {}
+-- Wavetables and workspaces are kept in a cache indexed by resource
+-- name and size. When the estimated memory used by the cache exceeds
+-- the budget the least recently used resources are released.
+local cache = {}
+local cache_bytes, cache_budget = 0, 16 * 1024 * 1024
+local cache_clock = 0
 
 local function res_allocator(name)
    local alloc = gsl['gsl_fft_' .. name .. '_alloc']
@@ -113,16 +117,53 @@ local cache_allocator = {
    real_workspace        = res_allocator('real_workspace')
 }
 
+-- approximate number of bytes used by a resource of size n
+local cache_sizeof = {
+   real_wavetable        = |n| n * ffi.sizeof('gsl_complex'),
+   halfcomplex_wavetable = |n| n * ffi.sizeof('gsl_complex'),
+   real_workspace        = |n| n * ffi.sizeof('double'),
+}
+
+for name in pairs(cache_allocator) do cache[name] = {} end
+
+local function cache_evict(budget)
+   while cache_bytes > budget do
+      local lru_name, lru_n, lru_entry
+      for name, entries in pairs(cache) do
+         for n, entry in pairs(entries) do
+            if not lru_entry or entry.stamp < lru_entry.stamp then
+               lru_name, lru_n, lru_entry = name, n, entry
+            end
+         end
+      end
+      if not lru_entry then break end
+      cache[lru_name][lru_n] = nil
+      cache_bytes = cache_bytes - lru_entry.bytes
+   end
+end
+
 local function get_resource(name, n)
-   local resource
-   if cache_n[name] ~= n then
-      resource = cache_allocator[name](n)
-      cache_n[name] = n
-      cache_r[name] = resource
-   else
-      resource = cache_r[name]
+   cache_clock = cache_clock + 1
+   local entry = cache[name][n]
+   if not entry then
+      local bytes = cache_sizeof[name](n)
+      cache_evict(cache_budget - bytes)
+      entry = {resource = cache_allocator[name](n), bytes = bytes}
+      cache[name][n] = entry
+      cache_bytes = cache_bytes + bytes
+   end
+   entry.stamp = cache_clock
+   return entry.resource
+end
+
+function num.fft_cache_budget(nbytes)
+   local previous = cache_budget
+   if nbytes then
+      check.number(nbytes)
+      cache_budget = nbytes
+      cache_evict(cache_budget)
    end
-   return resource
+   return previous
 end
 
 local function get_matrix_block(x, ip)
@@ -170,7 +211,7 @@ end
 function num.fftinv(ft, ip)
    local n = tonumber(ft.size)
    local b, data, stride = get_hc_block(ft, ip)
-   if is_two_power(n) then
+   if ffi.istype(fft_radix2_hc, ft) then
       gsl_check(gsl.gsl_fft_halfcomplex_radix2_inverse(data, stride, n))
    else
       local wt = get_resource('halfcomplex_wavetable', n)
@@ -180,6 +221,32 @@ function num.fftinv(ft, ip)
    return gsl_matrix(n, 1, stride, data, b, 1)
 end
 
+-- The transforms are always computed with the mixed-radix algorithm so
+-- that all the resulting half-complex vectors share the same packing,
+-- independently of their size.
+function num.fft_many(m, dim, ip)
+   dim = dim or 1
+   if dim ~= 1 and dim ~= 2 then error('dimension should be 1 or 2', 2) end
+   local n1, n2 = tonumber(m.size1), tonumber(m.size2)
+   if not ip then m = m:copy() end
+   local b, tda = m.block, tonumber(m.tda)
+   local n, count = n1, n2
+   local step, stride = 1, tda
+   if dim == 2 then n, count, step, stride = n2, n1, tda, 1 end
+
+   local wt = get_resource('real_wavetable', n)
+   local ws = get_resource('real_workspace', n)
+
+   local fts = {}
+   for k = 0, count - 1 do
+      local data = m.data + k * step
+      gsl_check(gsl.gsl_fft_real_transform(data, stride, n, wt, ws))
+      b.ref_count = b.ref_count + 1
+      fts[k+1] = fft_hc(n, stride, data, b)
+   end
+   return fts
+end
+
 local function halfcomplex_radix2_index(n, stride, k)
    if k < 0 or k >= n then error('invalid halfcomplex index', 2) end
    local half_n = n/2
@@ -274,12 +341,7 @@ local function hc_newindex(ft, k, z)
 end
 
 local function hc_free(hc)
-   local b = hc.block
-   b.ref_count = b.ref_count - 1
-   if b.ref_count == 0 then
-      ffi.C.free(b.data)
-      ffi.C.free(b)
-   end
+   matrix.block_release(hc.block)
 end
 
 ffi.metatype(fft_hc, {
@@ -19,6 +19,7 @@ FXDEFMAP(fx_console) fx_console_map[]=
     FXMAPFUNC(SEL_COMMAND, FXText::ID_DELETE_SEL, fx_console::on_cmd_delete),
     FXMAPFUNC(SEL_COMMAND, FXText::ID_INSERT_STRING, fx_console::on_cmd_insert_string),
     FXMAPFUNC(SEL_IO_READ, fx_console::ID_LUA_OUTPUT, fx_console::on_lua_output),
+    FXMAPFUNC(SEL_TIMEOUT, fx_console::ID_OUTPUT_TIMER, fx_console::on_output_timer),
 };
 
 FXIMPLEMENT(fx_console,FXText,fx_console_map,ARRAYNUMBER(fx_console_map))
@@ -27,19 +28,23 @@ const FXchar * fx_console::prompt = "> ";
 
 fx_console::fx_console(gsl_shell_thread* gs, io_redirect* lua_io, FXComposite *p, FXObject* tgt, FXSelector sel, FXuint opts, FXint x, FXint y, FXint w, FXint h, FXint pl, FXint pr, FXint pt, FXint pb):
     FXText(p, tgt, sel, opts, x, y, w, h, pl, pr, pt, pb),
-    m_status(not_ready), m_engine(gs), m_lua_io(lua_io)
+    m_status(not_ready), m_engine(gs), m_lua_io(lua_io),
+    m_output_timer(false), m_output_lines(0)
 {
     FXApp* app = getApp();
     m_lua_io_signal = new FXGUISignal(app, this, ID_LUA_OUTPUT);
-    m_lua_io_thread = new lua_io_thread(m_lua_io, m_lua_io_signal, &m_lua_io_mutex, &m_lua_io_buffer);
+    m_lua_io_buffer = new io_ring_buffer();
+    m_lua_io_thread = new lua_io_thread(m_lua_io, m_lua_io_signal, m_lua_io_buffer);
 
     init_styles();
 }
 
 fx_console::~fx_console()
 {
+    getApp()->removeTimeout(this, ID_OUTPUT_TIMER);
     delete m_lua_io_thread;
     delete m_lua_io_signal;
+    delete m_lua_io_buffer;
 }
 
 void fx_console::init_styles()
@@ -263,25 +268,92 @@ long fx_console::on_key_press(FXObject* obj, FXSelector sel, void* ptr)
     return FXText::onKeyPress(obj, sel, ptr);
 }
 
+// The output is shown immediately if nothing was shown in the last
+// frame interval otherwise it is left in the buffer for the timer.
 long fx_console::on_lua_output(FXObject* obj, FXSelector sel, void* ptr)
 {
-    bool eot = false;
+    m_lua_io_thread->notified();
+    if (!m_output_timer)
+        flush_output();
+    return 1;
+}
+
+long fx_console::on_output_timer(FXObject* obj, FXSelector sel, void* ptr)
+{
+    m_output_timer = false;
+    flush_output();
+    return 1;
+}
 
-    m_lua_io_mutex.lock();
-    FXint len = m_lua_io_buffer.length();
-    if (len > 0)
+// Append a chunk of output. Only the lines that fit in the scrollback
+// are actually inserted in the text widget.
+void fx_console::append_output(const FXString& text)
+{
+    FXint len = text.length(), start = 0, nl = 0;
+    for (FXint k = len - 1; k >= 0; k--)
     {
-        if (m_lua_io_buffer[len-1] == gsl_shell_thread::eot_character)
+        if (text[k] == '\n' && ++nl > scrollback_lines)
         {
-            eot = true;
-            m_lua_io_buffer.trunc(len-1);
+            start = k + 1;
+            nl--;
+            break;
         }
     }
-    appendText(m_lua_io_buffer);
+
+    appendText(text.text() + start, len - start);
+    m_output_lines += nl;
+}
+
+// Remove the oldest lines when the scrollback is exceeded. Some more
+// lines are removed so that this does not happen at each update.
+void fx_console::trim_scrollback()
+{
+    if (m_output_lines <= scrollback_lines)
+        return;
+
+    FXint excess = m_output_lines - scrollback_lines + scrollback_lines / 8;
+    FXint pos = nextLine(0, excess);
+    if (m_status == input_mode && pos > m_input_begin)
+        pos = lineStart(m_input_begin);
+    if (pos <= 0)
+        return;
+
+    removeText(0, pos);
+    m_input_begin = (m_input_begin > pos ? m_input_begin - pos : 0);
+    m_output_lines -= excess;
+}
+
+void fx_console::flush_output()
+{
+    const unsigned chunk_size = 65536;
+    char chunk[chunk_size];
+    FXString text;
+
+    while (1)
+    {
+        unsigned n = m_lua_io_buffer->read(chunk, chunk_size);
+        if (n == 0) break;
+        text.append(chunk, n);
+    }
+
+    if (text.empty())
+        return;
+
+    bool eot = false;
+    FXint eot_pos = text.find((FXchar) gsl_shell_thread::eot_character);
+    if (eot_pos >= 0)
+    {
+        eot = true;
+        text.erase(eot_pos, 1);
+    }
+
+    append_output(text);
+    trim_scrollback();
     makePositionVisible(getCursorPos());
 
-    m_lua_io_buffer.clear();
-    m_lua_io_mutex.unlock();
+    // no more output is shown before the end of the frame interval
+    getApp()->addTimeout(this, ID_OUTPUT_TIMER, output_frame_ms);
+    m_output_timer = true;
 
     if (eot)
     {
@@ -298,8 +370,6 @@ long fx_console::on_lua_output(FXObject* obj, FXSelector sel, void* ptr)
             prepare_input();
         }
     }
-
-    return 1;
 }
 
 long fx_console::on_cmd_delete(FXObject* obj, FXSelector sel, void* ptr)
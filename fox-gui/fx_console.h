@@ -39,11 +39,13 @@ public:
     long on_cmd_delete(FXObject*,FXSelector,void*);
     long on_cmd_insert_string(FXObject*,FXSelector,void*);
     long on_lua_output(FXObject*,FXSelector,void*);
+    long on_output_timer(FXObject*,FXSelector,void*);
 
     enum
     {
         ID_READ_INPUT = FXText::ID_LAST,
         ID_LUA_OUTPUT,
+        ID_OUTPUT_TIMER,
         ID_LAST,
     };
 
@@ -51,7 +53,15 @@ protected:
     fx_console() {}
 
 private:
+    // the output is shown at most once in this interval, in milliseconds
+    enum { output_frame_ms = 40 };
+    // maximum number of output lines kept in the console
+    enum { scrollback_lines = 10000 };
+
     void init_styles();
+    void flush_output();
+    void append_output(const FXString& text);
+    void trim_scrollback();
 
 private:
     FXint m_input_begin;
@@ -62,8 +72,9 @@ private:
 
     lua_io_thread* m_lua_io_thread;
     FXGUISignal* m_lua_io_signal;
-    FXMutex m_lua_io_mutex;
-    FXString m_lua_io_buffer;
+    io_ring_buffer* m_lua_io_buffer;
+    bool m_output_timer;
+    FXint m_output_lines;
     FXString m_input_acc;
 
     FXString m_saved_line;
@@ -9,38 +9,161 @@
 FXDEFMAP(fx_plot_canvas) fx_plot_canvas_map[]=
 {
     FXMAPFUNC(SEL_PAINT,     0, fx_plot_canvas::on_cmd_paint),
+    FXMAPFUNC(SEL_IO_READ,   fx_plot_canvas::ID_UPDATE_REGION, fx_plot_canvas::on_update_region),
 };
 
 FXIMPLEMENT(fx_plot_canvas,FXCanvas,fx_plot_canvas_map,ARRAYNUMBER(fx_plot_canvas_map));
 
+static const unsigned fox_pixel_size = 4;
+
 fx_plot_canvas::fx_plot_canvas(FXComposite* p, FXObject* tgt, FXSelector sel, FXuint opts, FXint x, FXint y, FXint w, FXint h):
-    FXCanvas(p, tgt, sel, opts, x, y, w, h)
+    FXCanvas(p, tgt, sel, opts, x, y, w, h), m_image(0), m_region_image(0),
+    m_image_stale(false), m_signal_pending(false)
+{
+    m_update_signal = new FXGUISignal(getApp(), this, ID_UPDATE_REGION);
+}
+
+fx_plot_canvas::~fx_plot_canvas()
 {
+    delete m_update_signal;
+    delete m_image;
+    delete m_region_image;
 }
 
+// Called with the application mutex locked, either by the Lua thread
+// or by the GUI thread. The region is merged with the ones still
+// pending and the GUI thread is woken only once for all of them.
 void fx_plot_canvas::update_region(const agg::rect_i& r)
 {
-    FXshort ww = r.x2 - r.x1, hh= r.y2 - r.y1;
-    if (ww <= 0 || hh <= 0) return;
+    if (r.x2 <= r.x1 || r.y2 <= r.y1) return;
 
-    const window_surface::image& src_img = m_surface->get_image();
+    m_pending.add<rect_union>(r);
+    if (!m_signal_pending)
+    {
+        m_signal_pending = true;
+        m_update_signal->signal();
+    }
+}
+
+// Make sure that "img" exists with the given size. The image is kept
+// between the updates and reallocated only when the size changes.
+// Return true if the image is new or has been resized.
+bool fx_plot_canvas::ensure_image(FXImage*& img, int ww, int hh)
+{
+    if (img && img->getWidth() == ww && img->getHeight() == hh)
+        return false;
+
+    if (img)
+    {
+        img->resize(ww, hh);
+    }
+    else
+    {
+        img = new FXImage(getApp(), NULL, IMAGE_OWNED|IMAGE_KEEP|IMAGE_SHMI|IMAGE_SHMP, ww, hh);
+        img->create();
+    }
+    return true;
+}
+
+// The size of the region image is rounded up to multiples of
+// region_bucket pixels and the image is never shrunk so that it is
+// not resized each time the size of the updated region changes.
+static const int region_bucket = 64;
+
+static int round_up_bucket(int n)
+{
+    return ((n + region_bucket - 1) / region_bucket) * region_bucket;
+}
+
+void fx_plot_canvas::ensure_region_image(int w, int h)
+{
+    int rw = w, rh = h;
+    if (m_region_image)
+    {
+        if (m_region_image->getWidth() >= w && m_region_image->getHeight() >= h)
+            return;
+        rw = FXMAX(rw, m_region_image->getWidth());
+        rh = FXMAX(rh, m_region_image->getHeight());
+    }
+    ensure_image(m_region_image, round_up_bucket(rw), round_up_bucket(rh));
+}
 
-    FXImage img(getApp(), NULL, IMAGE_OWNED|IMAGE_SHMI|IMAGE_SHMP, ww, hh);
+// Convert the pending region of the window surface into the client
+// side pixels of the image. The window surface is rgb24 like the rest
+// of the AGG rendering pipeline so the pixels are converted to the
+// FOX format, only in the pending region. The image is sent to the
+// server only when a paint event needs it.
+void fx_plot_canvas::convert_pending()
+{
+    const window_surface::image& src_img = m_surface->get_image();
+    const int ww = m_image->getWidth(), hh = m_image->getHeight();
 
-    const unsigned fox_pixel_size = 4;
+    agg::rect_i r = m_pending.rect();
+    m_pending.clear();
+    if (!r.clip(agg::rect_i(0, 0, ww, hh))) return;
+    if (!r.clip(agg::rect_i(0, 0, src_img.width(), src_img.height()))) return;
 
-    agg::rendering_buffer dest;
-    dest.attach((agg::int8u*) img.getData(), ww, hh, -ww * fox_pixel_size);
+    agg::rendering_buffer dest_img, dest;
+    dest_img.attach((agg::int8u*) m_image->getData(), ww, hh, -ww * fox_pixel_size);
+    rendering_buffer_get_view(dest, dest_img, r, fox_pixel_size);
 
     rendering_buffer_ro src;
     rendering_buffer_get_const_view(src, src_img, r, window_surface::image_pixel_width);
 
     my_color_conv(&dest, &src, color_conv_rgb24_to_rgba32());
+    m_image_stale = true;
+}
+
+// Send the region "r" of the image to the server and copy it to the
+// window. The region is copied in a separate image, large enough to
+// contain it, and only that part of the image is drawn on the window.
+void fx_plot_canvas::draw_region(FXDCWindow& dc, const agg::rect_i& r)
+{
+    const int ww = m_image->getWidth(), hh = m_image->getHeight();
+    const int w = r.x2 - r.x1, h = r.y2 - r.y1;
+    ensure_region_image(w, h);
+    const int rw = m_region_image->getWidth();
+
+    agg::rendering_buffer img_buf, src, dest;
+    img_buf.attach((agg::int8u*) m_image->getData(), ww, hh, -ww * fox_pixel_size);
+    rendering_buffer_get_view(src, img_buf, r, fox_pixel_size);
+    // the rows of the region image are rw pixels wide but only the
+    // top-left w x h corner is used
+    dest.attach((agg::int8u*) m_region_image->getData(), w, h, -rw * fox_pixel_size);
+    dest.copy_from(src);
+
+    m_region_image->render();
+    dc.drawArea(m_region_image, 0, 0, w, h, r.x1, hh - r.y2);
+}
 
-    img.create();
+long fx_plot_canvas::on_update_region(FXObject *, FXSelector, void *)
+{
+    m_signal_pending = false;
+    if (!m_pending.is_defined() || !m_surface || !id())
+        return 1;
+
+    const int ww = getWidth(), hh = getHeight();
+    if (!m_surface->canvas_size_match(ww, hh))
+    {
+        // a paint event with the new size will follow
+        m_pending.clear();
+        return 1;
+    }
+
+    if (ensure_image(m_image, ww, hh))
+        m_pending.set(0, 0, ww, hh);
+
+    agg::rect_i r = m_pending.rect();
+    if (!r.clip(agg::rect_i(0, 0, ww, hh)))
+    {
+        m_pending.clear();
+        return 1;
+    }
+    convert_pending();
 
     FXDCWindow dc(this);
-    dc.drawImage(&img, r.x1, getHeight() - r.y2);
+    draw_region(dc, r);
+    return 1;
 }
 
 long fx_plot_canvas::on_cmd_paint(FXObject *, FXSelector, void *ptr)
@@ -51,9 +174,25 @@ long fx_plot_canvas::on_cmd_paint(FXObject *, FXSelector, void *ptr)
     {
         m_surface->resize(ww, hh);
         m_surface->draw_image_buffer();
+        m_pending.set(0, 0, ww, hh);
+    }
+
+    if (ensure_image(m_image, ww, hh))
+        m_pending.set(0, 0, ww, hh);
+
+    if (m_pending.is_defined())
+        convert_pending();
+
+    // the whole image is sent to the server only if some region has
+    // changed since the last paint event
+    if (m_image_stale)
+    {
+        m_image->render();
+        m_image_stale = false;
     }
 
-    agg::rect_i r(0, 0, ww, hh);
-    update_region(r);
+    // only the exposed area is copied from the image
+    FXDCWindow dc(this, (FXEvent*) ptr);
+    dc.drawImage(m_image, 0, 0);
     return 1;
 }
@@ -7,6 +7,8 @@
 #include <agg_rendering_buffer.h>
 #include <agg_trans_affine.h>
 
+#include "rect.h"
+
 class window_surface;
 
 class fx_plot_canvas : public FXCanvas
@@ -15,18 +17,48 @@ class fx_plot_canvas : public FXCanvas
 public:
     fx_plot_canvas(FXComposite* p, FXObject* tgt=NULL, FXSelector sel=0, FXuint opts=FRAME_NORMAL,
                    FXint x=0, FXint y=0, FXint w=0, FXint h=0);
+    ~fx_plot_canvas();
 
+    // Mark a region of the window surface to be shown. The regions
+    // are collected and uploaded together by the GUI thread.
     void update_region(const agg::rect_i& r);
 
     void attach_surface(window_surface* surf) { m_surface = surf; }
 
     long on_cmd_paint(FXObject *, FXSelector, void *);
+    long on_update_region(FXObject *, FXSelector, void *);
+
+    enum {
+        ID_UPDATE_REGION = FXCanvas::ID_LAST,
+        ID_LAST
+    };
 
 protected:
-    fx_plot_canvas() {}
+    fx_plot_canvas(): m_image(0), m_region_image(0), m_update_signal(0) {}
 
 private:
+    bool ensure_image(FXImage*& img, int ww, int hh);
+    void ensure_region_image(int w, int h);
+    void convert_pending();
+    void draw_region(FXDCWindow& dc, const agg::rect_i& r);
+
     window_surface* m_surface;
+
+    // persistent copy of the surface image in the FOX pixel format
+    FXImage* m_image;
+
+    // image used to send only an updated region to the server, it
+    // only grows and the region is stored in its top-left corner
+    FXImage* m_region_image;
+
+    // true if the client pixels of m_image are newer than the copy
+    // on the server
+    bool m_image_stale;
+
+    // union of the regions not yet uploaded to m_image
+    opt_rect<int> m_pending;
+    FXGUISignal* m_update_signal;
+    bool m_signal_pending;
 };
 
 #endif
@@ -23,7 +23,7 @@ FXIMPLEMENT(gsl_shell_app,FXApp,gsl_shell_app_map,ARRAYNUMBER(gsl_shell_app_map)
 gsl_shell_app* global_app;
 
 gsl_shell_app::gsl_shell_app():
-FXApp("GSL Shell", "GSL Shell"), m_engine(this), m_redirect(2048, 2048)
+FXApp("GSL Shell", "GSL Shell"), m_engine(this), m_redirect(65536, 2048)
 {
     m_signal_request = new FXGUISignal(this, this, ID_LUA_REQUEST);
 
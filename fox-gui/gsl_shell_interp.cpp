@@ -14,6 +14,9 @@ extern "C" {
 #include "gsl_shell_interp.h"
 #include "lua-gsl.h"
 #include "lua-graph.h"
+#ifdef GSL_SHELL_BUNDLE
+#include "lua-bundle.h"
+#endif
 #include "fatal.h"
 
 static void stderr_message(const char *pname, const char *msg)
@@ -84,6 +87,9 @@ static int pinit(lua_State *L)
     luaL_openlibs(L);  /* open libraries */
     luaopen_gsl (L);
     register_graph (L);
+#ifdef GSL_SHELL_BUNDLE
+    lua_bundle_open (L);
+#endif
     lua_gc(L, LUA_GCRESTART, -1);
     dolibrary (L, "gslext");
     return 0;
@@ -0,0 +1,70 @@
+#ifndef FOXGUI_IO_RING_BUFFER_H
+#define FOXGUI_IO_RING_BUFFER_H
+
+#include <string.h>
+
+/* Ring buffer of bytes shared between exactly one producer thread and
+   one consumer thread. No lock is needed: the producer only moves the
+   head and the consumer only moves the tail. Each thread reads the
+   index of the other one with an acquire load, so that the data copied
+   before the index was published are visible, and publishes its own
+   index with a release store after copying the data. The positions
+   are free running counters and the size is a power of two. */
+class io_ring_buffer {
+public:
+    enum { size = 1 << 20 };
+
+    io_ring_buffer(): m_head(0), m_tail(0) { }
+
+    // Called by the producer. Copy up to "n" bytes and return the
+    // number of bytes actually stored.
+    unsigned write(const char* src, unsigned n)
+    {
+        const unsigned head = m_head;
+        const unsigned tail = __atomic_load_n(&m_tail, __ATOMIC_ACQUIRE);
+        const unsigned avail = size - (head - tail);
+        if (n > avail) n = avail;
+        copy_in(head, src, n);
+        __atomic_store_n(&m_head, head + n, __ATOMIC_RELEASE);
+        return n;
+    }
+
+    // Called by the consumer. Copy up to "n" bytes in "dst" and return
+    // the number of bytes read.
+    unsigned read(char* dst, unsigned n)
+    {
+        const unsigned tail = m_tail;
+        const unsigned head = __atomic_load_n(&m_head, __ATOMIC_ACQUIRE);
+        const unsigned avail = head - tail;
+        if (n > avail) n = avail;
+        copy_out(tail, dst, n);
+        __atomic_store_n(&m_tail, tail + n, __ATOMIC_RELEASE);
+        return n;
+    }
+
+    bool empty() const
+    {
+        return __atomic_load_n(&m_head, __ATOMIC_RELAXED) == __atomic_load_n(&m_tail, __ATOMIC_RELAXED);
+    }
+
+private:
+    void copy_in(unsigned pos, const char* src, unsigned n)
+    {
+        const unsigned i = pos & (size - 1), n1 = (n < size - i ? n : size - i);
+        memcpy(m_data + i, src, n1);
+        memcpy(m_data, src + n1, n - n1);
+    }
+
+    void copy_out(unsigned pos, char* dst, unsigned n)
+    {
+        const unsigned i = pos & (size - 1), n1 = (n < size - i ? n : size - i);
+        memcpy(dst, m_data + i, n1);
+        memcpy(dst + n1, m_data, n - n1);
+    }
+
+    unsigned m_head; // written only by the producer
+    unsigned m_tail; // written only by the consumer
+    char m_data[size];
+};
+
+#endif
@@ -1,5 +1,6 @@
 #include <pthread.h>
 #include <errno.h>
+#include <unistd.h>
 
 #include "io_thread.h"
 
@@ -10,13 +11,20 @@ static void* io_thread_run(void* data)
     return 0;
 }
 
+void lua_io_thread::notify()
+{
+    if (__sync_bool_compare_and_swap(&m_signal_pending, 0, 1))
+        m_io_ready->signal();
+}
+
 void lua_io_thread::run()
 {
-    char buffer[128];
+    const int read_size = 16384;
+    char buffer[read_size];
 
     while (1)
     {
-        int nr = m_redirect->read(buffer, 127);
+        int nr = m_redirect->read(buffer, read_size);
         if (nr < 0)
         {
             fprintf(stderr, "ERROR on read: %d.\n", errno);
@@ -25,13 +33,19 @@ void lua_io_thread::run()
         if (nr == 0)
             break;
 
-        buffer[nr] = 0;
-
-        m_io_protect->lock();
-        m_io_buffer->append((const FXchar*)buffer);
-        m_io_protect->unlock();
-
-        m_io_ready->signal();
+        // when the buffer is full we wait for the GUI to consume some
+        // data. In the meantime the Lua engine will block on its
+        // writes to the pipe.
+        const char* p = buffer;
+        while (nr > 0)
+        {
+            unsigned nw = m_io_buffer->write(p, nr);
+            p += nw;
+            nr -= nw;
+            notify();
+            if (nr > 0)
+                usleep(2000);
+        }
     }
 }
 
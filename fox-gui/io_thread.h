@@ -5,22 +5,32 @@
 
 #include "gsl_shell_thread.h"
 #include "redirect.h"
+#include "io_ring_buffer.h"
 
+/* Thread that reads the output of the Lua engine from the redirected
+   stdout and stores it in a ring buffer. The GUI is signaled only
+   when it has consumed the previous notification. */
 class lua_io_thread {
 public:
-    lua_io_thread(io_redirect* lua_io, FXGUISignal* sig, FXMutex* mut, FXString* buf):
-        m_redirect(lua_io), m_io_ready(sig), m_io_protect(mut), m_io_buffer(buf)
+    lua_io_thread(io_redirect* lua_io, FXGUISignal* sig, io_ring_buffer* buf):
+        m_redirect(lua_io), m_io_ready(sig), m_io_buffer(buf), m_signal_pending(0)
     { }
 
     void run();
     void start();
 
+    // Called by the GUI thread before reading the buffer so that any
+    // data written after that will raise a new signal.
+    void notified() { __sync_lock_release(&m_signal_pending); }
+
 private:
+    void notify();
+
     pthread_t m_thread;
     io_redirect* m_redirect;
     FXGUISignal* m_io_ready;
-    FXMutex* m_io_protect;
-    FXString* m_io_buffer;
+    io_ring_buffer* m_io_buffer;
+    volatile int m_signal_pending;
 };
 
 #endif
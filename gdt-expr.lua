@@ -1,6 +1,8 @@
 local expr_print = require 'expr-print'
+local AST = require 'expr-actions'
 
 local pairs, ipairs = pairs, ipairs
+local format, concat = string.format, table.concat
 
 local gdt_expr = {}
 
@@ -50,6 +52,109 @@ local table_scope = {
 
 gdt_expr.table_scope = table_scope
 
+-- Compilation of the expressions into Lua functions of the form
+-- f(t, i) that evaluate the expression for the row "i" of the table.
+-- The column indexes are resolved at compile time and the operators
+-- are inlined so that the JIT can trace a tight loop over the rows.
+-- Like expr_print.eval the function returns nil if any of the
+-- referenced values is undefined.
+
+local compare_operators = {['>'] = true, ['<'] = true, ['>='] = true, ['<='] = true}
+local arith_operators = {['+'] = true, ['-'] = true, ['*'] = true, ['/'] = true, ['^'] = true}
+
+local function compile_operator(op, a, b)
+    if arith_operators[op] then
+        return format('(%s %s %s)', a, op, b)
+    elseif compare_operators[op] then
+        return format('(%s %s %s and 1 or 0)', a, op, b)
+    elseif op == '=' then
+        return format('(%s == %s and 1 or 0)', a, b)
+    elseif op == '!=' then
+        return format('(%s ~= %s and 1 or 0)', a, b)
+    elseif op == 'and' then
+        return format('((%s ~= 0 and %s ~= 0) and 1 or 0)', a, b)
+    elseif op == 'or' then
+        return format('((%s ~= 0 or %s ~= 0) and 1 or 0)', a, b)
+    else
+        error('unknown operation: ' .. op)
+    end
+end
+
+local function compile_term(expr, ctx)
+    if type(expr) == 'number' then
+        -- "%.17g" gives "inf" or "nan" that are not valid Lua numbers
+        if expr ~= expr then return '(0/0)' end
+        if expr == 1/0 then return '(1/0)' end
+        if expr == -1/0 then return '(-1/0)' end
+        return format('%.17g', expr)
+    elseif AST.is_variable(expr) then
+        local _, var_name = AST.is_variable(expr)
+        local var = ctx.vars[var_name]
+        if not var then
+            local j = ctx.table:col_index(var_name)
+            if not j then
+                error(format("invalid column name \"%s\"", var_name), 3)
+            end
+            var = 'v' .. j
+            ctx.vars[var_name] = var
+            ctx.columns[#ctx.columns+1] = j
+        end
+        return var
+    elseif expr.literal then
+        return format('%q', expr.literal)
+    elseif expr.func then
+        if not math[expr.func] then error('unknown function: ' .. expr.func) end
+        ctx.funcs[expr.func] = true
+        return format('f_%s(%s)', expr.func, compile_term(expr.arg, ctx))
+    elseif #expr == 1 then
+        return format('(- %s)', compile_term(expr[1], ctx))
+    else
+        local a = compile_term(expr[1], ctx)
+        local b = compile_term(expr[2], ctx)
+        return compile_operator(expr.operator, a, b)
+    end
+end
+
+local compiled_cache = {}
+
+local function compile_expr(expr, t)
+    local ctx = {table = t, vars = {}, columns = {}, funcs = {}}
+    local term = compile_term(expr, ctx)
+
+    local code = {'local get, math = ...'}
+    for name in pairs(ctx.funcs) do
+        code[#code+1] = format('local f_%s = math.%s', name, name)
+    end
+    code[#code+1] = 'return function(t, i)'
+    for _, j in ipairs(ctx.columns) do
+        code[#code+1] = format('    local v%d = get(t, i, %d)', j, j)
+        code[#code+1] = format('    if v%d == nil then return nil end', j)
+    end
+    code[#code+1] = '    return ' .. term
+    code[#code+1] = 'end'
+    local src = concat(code, '\n')
+
+    local f = compiled_cache[src]
+    if not f then
+        local chunk = assert(loadstring(src, 'gdt expression'))
+        f = chunk(gdt.get_unsafe, math)
+        compiled_cache[src] = f
+    end
+    return f
+end
+
+gdt_expr.compile = compile_expr
+
+local function column_indexes(t, names)
+    local index = {}
+    for k, name in ipairs(names) do
+        local j = t:col_index(name)
+        if not j then error(format("invalid column name \"%s\"", name), 3) end
+        index[k] = j
+    end
+    return index
+end
+
 local function map_missing_rows(t, expr_list, y_expr_scalar, conditions)
     local refs, factor_refs, levels = {}, {}, {}
     for k, expr in ipairs(expr_list) do
@@ -59,28 +164,39 @@ local function map_missing_rows(t, expr_list, y_expr_scalar, conditions)
         expr_print.references(y_expr_scalar, refs)
     end
 
+    local ref_names, factor_names = {}, {}
+    for col_name in pairs(refs) do ref_names[#ref_names+1] = col_name end
     for factor_name in pairs(factor_refs) do
         levels[factor_name] = {}
+        factor_names[#factor_names+1] = factor_name
     end
+    local ref_index = column_indexes(t, ref_names)
+    local factor_index = column_indexes(t, factor_names)
 
+    local cond_eval = {}
+    for k, cond in ipairs(conditions) do
+        cond_eval[k] = compile_expr(cond, t)
+    end
+
+    local get = gdt.get_unsafe
     local N = #t
     local index_map = {}
     local map_i, map_len = 1, 0
     for i = 1, N do
         local row_undef = false
-        for col_name in pairs(refs) do
-            row_undef = row_undef or (not t:get(i, col_name))
+        for _, j in ipairs(ref_index) do
+            row_undef = row_undef or (not get(t, i, j))
         end
 
         if not row_undef then
-            for _, cond in ipairs(conditions) do
-                local cx = expr_print.eval(cond, table_scope, t, i)
+            for _, eval_cond in ipairs(cond_eval) do
+                local cx = eval_cond(t, i)
                 row_undef = row_undef or (cx == 0)
             end
         end
         if not row_undef then
-            for col_name in pairs(factor_refs) do
-                list_add_unique(levels[col_name], t:get(i, col_name))
+            for k, j in ipairs(factor_index) do
+                list_add_unique(levels[factor_names[k]], get(t, i, j))
             end
         end
         if row_undef then
@@ -132,6 +248,29 @@ local function index_map_iter(index_map, ils)
     end
 end
 
+-- split the index map in a list of index maps each one covering at
+-- most "size" rows of the model matrix
+local function index_map_chunks(index_map, size)
+    local chunks = {}
+    local chunk, count = {}, 0
+    for k, i, len in iter_by_two, index_map, -1 do
+        while len > 0 do
+            local l = math.min(len, size - count)
+            local n = #chunk
+            chunk[n+1], chunk[n+2] = i, l
+            i, len, count = i + l, len - l, count + l
+            if count == size then
+                chunks[#chunks+1] = chunk
+                chunk, count = {}, 0
+            end
+        end
+    end
+    if count > 0 then chunks[#chunks+1] = chunk end
+    return chunks
+end
+
+gdt_expr.index_map_chunks = index_map_chunks
+
 local function annotate_mult(expr_list, levels)
     local n = 0
     for _, expr in ipairs(expr_list) do
@@ -195,14 +334,6 @@ local function predlist_add_coeff_names(names, pred_list, expr)
     end
 end
 
-local function eval_pred_list(t, pred, i)
-    local match = true
-    for k, name, level in iter_by_two, pred, -1 do
-        match = match and (t:get(i, name) == level)
-    end
-    return (match and 1 or 0)
-end
-
 local function eval_coeff_names(expr_list, levels)
     local names = {}
     for _, expr in ipairs(expr_list) do
@@ -242,22 +373,39 @@ function gdt_expr.eval_matrix(t, info, expr_list, y_expr, index_map)
 
     local NE, XM = #expr_list, info.dim
 
+    local get = gdt.get_unsafe
+
     local function set_scalar_column(X, expr_scalar, j)
+        local eval_scalar = compile_expr(expr_scalar, t)
+        local data, tda = X.data, tonumber(X.tda)
         for _, i, x_i in index_map_iter, index_map, {-1, 0, 0} do
-            local xs = expr_print.eval(expr_scalar, table_scope, t, i)
+            local xs = eval_scalar(t, i)
             assert(xs, string.format('missing value in data table at row: %d', i))
-            X:set(x_i, j, xs)
+            data[(x_i - 1) * tda + (j - 1)] = xs
         end
     end
 
     local function set_contrasts_matrix(X, expr, j)
+        local eval_scalar = compile_expr(expr.scalar, t)
         local pred_list = eval_predicates(expr.factor, info.levels)
+        local pred_index = {}
+        for k, pred in ipairs(pred_list) do
+            local pi = {}
+            for p, name, level in iter_by_two, pred, -1 do
+                pi[p], pi[p+1] = t:col_index(name), level
+            end
+            pred_index[k] = pi
+        end
+        local data, tda = X.data, tonumber(X.tda)
         for _, i, x_i in index_map_iter, index_map, {-1, 0, 0} do
-            local xs = expr_print.eval(expr.scalar, table_scope, t, i)
+            local xs = eval_scalar(t, i)
             assert(xs, string.format('missing value in data table at row: %d', i))
-            for k, pred in ipairs(pred_list) do
-                local fs = eval_pred_list(t, pred, i)
-                X:set(x_i, j + (k - 1), xs * fs)
+            for k, pi in ipairs(pred_index) do
+                local match = true
+                for p = 1, #pi, 2 do
+                    match = match and (get(t, i, pi[p]) == pi[p+1])
+                end
+                data[(x_i - 1) * tda + (j + k - 2)] = xs * (match and 1 or 0)
             end
         end
     end
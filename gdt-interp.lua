@@ -1,8 +1,10 @@
+local ffi = require 'ffi'
 local expr_parse = require 'expr-parse'
 local gdt_expr = require 'gdt-expr'
 local gdt_factors = require 'gdt-factors'
 local AST = require 'expr-actions'
 local cgsl = require 'gsl'
+local gsl_check = require 'gsl-check'
 
 local interp_lookup = {
     linear           = cgsl.gsl_interp_linear,
@@ -13,42 +15,119 @@ local interp_lookup = {
     akima_periodic   = cgsl.gsl_interp_akima_periodic,
 }
 
-function gdt.interp(t, expr_formula, interp_type)
-    local schema = expr_parse.schema(expr_formula, AST, false)
-    local x_exprs = gdt_factors.compute(t, schema.x)
+local Interp = {}
+Interp.__index = Interp
+
+-- Evaluate the k-th y column at x_req. Outside of the x range the
+-- interpolation is extended linearly using the derivative at the end
+-- points. The accelerator should point to the interval of x_req if it
+-- is known.
+local function eval_column(s, k, x_req)
+    if x_req <= s.x_a then
+        return (x_req - s.x_a) * s.y_der_a[k] + s.ya[k][0]
+    elseif x_req >= s.x_b then
+        return (x_req - s.x_b) * s.y_der_b[k] + s.ya[k][s.n - 1]
+    else
+        return cgsl.gsl_interp_eval(s.interp[k], s.xa, s.ya[k], x_req, s.accel)
+    end
+end
+
+function Interp.__call(s, x_req)
+    if s.ny == 1 then
+        return eval_column(s, 0, x_req)
+    end
+    local ys = {}
+    for k = 0, s.ny - 1 do
+        ys[k + 1] = eval_column(s, k, x_req)
+    end
+    return unpack(ys)
+end
+
+local function is_sorted(xs, n, tda)
+    for i = 1, n - 1 do
+        if xs[i * tda] < xs[(i - 1) * tda] then return false end
+    end
+    return true
+end
+
+-- Evaluate the interpolation for each element of the column matrix or
+-- table "xs". Return a matrix with a row for each point and a column
+-- for each y variable. If the points are in increasing order the
+-- intervals are found by walking along the x data so that no search
+-- is needed.
+function Interp.eval_many(s, xs, out)
+    if type(xs) == 'table' then xs = matrix.vec(xs) end
+    local n, ny = tonumber(xs.size1), s.ny
+    local y = out or matrix.alloc(n, ny)
+    if y.size1 ~= n or y.size2 ~= ny then
+        error(string.format('output matrix should be %d x %d', n, ny), 2)
+    end
 
-    if #x_exprs > 1 or x_exprs.factor then
+    local xd, xtda, yd, ytda = xs.data, tonumber(xs.tda), y.data, tonumber(y.tda)
+    local xa, accel, nd = s.xa, s.accel, s.n
+    local sorted = is_sorted(xd, n, xtda)
+    local i = 0
+    for j = 0, n - 1 do
+        local x_req = xd[j * xtda]
+        if sorted and x_req > s.x_a and x_req < s.x_b then
+            while x_req >= xa[i + 1] do i = i + 1 end
+            accel.cache = i
+        end
+        for k = 0, ny - 1 do
+            yd[j * ytda + k] = eval_column(s, k, x_req)
+        end
+    end
+    return y
+end
+
+function gdt.interp(t, expr_formula, interp_type)
+    local schema = expr_parse.schema_multivar(expr_formula, AST)
+    if #schema.x > 1 or #schema.enums > 0 then
         error('only a single numeric x variable can be given')
     end
 
     local T = interp_lookup[interp_type or "cspline"]
     if T == nil then error("invalid interpolator type") end
 
-    local info, index_map = gdt_expr.prepare_model(t, x_exprs, schema.y.scalar)
-    local X, y = gdt_expr.eval_matrix(t, info, x_exprs, schema.y, index_map)
+    -- the x and the y variables are evaluated as the columns of a
+    -- single matrix so that the rows with missing values are
+    -- discarded for all of them
+    local vars = {schema.x[1]}
+    for k, y_expr in ipairs(schema.y) do vars[k + 1] = y_expr end
+    local exprs = gdt_factors.compute(t, vars)
+    for _, e in ipairs(exprs) do
+        if e.factor then error('factors cannot be used for interpolation') end
+    end
+
+    local info, index_map = gdt_expr.prepare_model(t, exprs, nil, schema.conds)
+    local M = gdt_expr.eval_matrix(t, info, exprs, nil, index_map)
 
-    local n = #y
+    local n, ny = tonumber(M.size1), #schema.y
     local n_min = cgsl.gsl_interp_type_min_size(T)
     if n < n_min then
         error(string.format('not enough data for interpolation, at least %d needed', n_min))
     end
-    local interp = ffi.gc(cgsl.gsl_interp_alloc(T, n), cgsl.gsl_interp_free)
-    local accel = ffi.gc(cgsl.gsl_interp_accel_alloc(), cgsl.gsl_interp_accel_free)
-    cgsl.gsl_interp_init(interp, X.data, y.data, n)
-
-    local x_a, x_b = X.data[0], X.data[n-1]
-    local y_a, y_b = y.data[0], y.data[n-1]
-    local y_der_a = cgsl.gsl_interp_eval_deriv(interp, X.data, y.data, x_a, acc)
-    local y_der_b = cgsl.gsl_interp_eval_deriv(interp, X.data, y.data, x_b, acc)
-
-    local function eval(x_req)
-        if x_req <= x_a then
-            return (x_req - x_a) * y_der_a + y_a
-        elseif x_req >= x_b then
-            return (x_req - x_b) * y_der_b + y_b
-        else
-            return cgsl.gsl_interp_eval(interp, X.data, y.data, x_req, acc)
+
+    -- GSL needs the x and y values in contiguous arrays
+    local data = matrix.alloc(ny + 1, n)
+    for i = 0, n - 1 do
+        for k = 0, ny do
+            data.data[k * n + i] = M.data[i * M.tda + k]
         end
     end
-    return eval
+
+    local xa = data.data
+    local s = {n= n, ny= ny, data= data, xa= xa, ya= {}, interp= {},
+               y_der_a= {}, y_der_b= {}, x_a= xa[0], x_b= xa[n-1]}
+    s.accel = ffi.gc(cgsl.gsl_interp_accel_alloc(), cgsl.gsl_interp_accel_free)
+    for k = 0, ny - 1 do
+        local ya = data.data + (k + 1) * n
+        local interp = ffi.gc(cgsl.gsl_interp_alloc(T, n), cgsl.gsl_interp_free)
+        gsl_check(cgsl.gsl_interp_init(interp, xa, ya, n))
+        s.ya[k], s.interp[k] = ya, interp
+        s.y_der_a[k] = cgsl.gsl_interp_eval_deriv(interp, xa, ya, s.x_a, s.accel)
+        s.y_der_b[k] = cgsl.gsl_interp_eval_deriv(interp, xa, ya, s.x_b, s.accel)
+    end
+
+    return setmetatable(s, Interp)
 end
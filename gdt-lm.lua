@@ -6,6 +6,9 @@ local check = require 'check'
 local mon = require 'monomial'
 local AST = require 'expr-actions'
 local linfit_rank = require 'linfit_rank'
+local ffi = require 'ffi'
+local gsl = require 'gsl'
+local gsl_check = require 'gsl-check'
 
 local sqrt, abs = math.sqrt, math.abs
 local ipairs = ipairs
@@ -55,9 +58,7 @@ local function list_exists(ls, x)
     return false
 end
 
-local function compute_fit(X, y, names)
-    local n, p = matrix.dim(X)
-    local c, chisq, cov, remov = linfit_rank(X, y)
+local function compute_fit_coeff(names, n, p, c, chisq, cov, remov)
     local rank = p - #remov
     local coeff = gdt.alloc(p, {"term", "estimate", "std error", "t value" ,"Pr(>|t|)"})
     for i = 1, p do
@@ -75,8 +76,21 @@ local function compute_fit(X, y, names)
     return {coeff = coeff, c = c, chisq = chisq, cov = cov, n = n, p = p, rank= rank}
 end
 
-local function fit_compute_Rsquare(fit, X, y)
+local function compute_fit(X, y, names)
+    local n, p = matrix.dim(X)
+    local c, chisq, cov, remov = linfit_rank(X, y)
+    return compute_fit_coeff(names, n, p, c, chisq, cov, remov)
+end
+
+local function fit_Rsquare_stats(fit, SS_reg, SS_tot)
     local n, p = fit.n, fit.rank
+    local R2 = 1 - SS_reg/SS_tot
+    local R2_adj = R2 - (1 - R2) * p / (n - p - 1)
+    local SE = sqrt(SS_reg / (n - p))
+    return SE, R2, R2_adj
+end
+
+local function fit_compute_Rsquare(fit, X, y)
     local y_pred = X * fit.c
 
     local y_mean = 0
@@ -89,11 +103,7 @@ local function fit_compute_Rsquare(fit, X, y)
         SS_tot = SS_tot + (y:get(k, 1) - y_mean)^2
     end
 
-    local R2 = 1 - SS_reg/SS_tot
-    local R2_adj = R2 - (1 - R2) * p / (n - p - 1)
-    local SE = sqrt(SS_reg / (n - p))
-
-    return SE, R2, R2_adj
+    return fit_Rsquare_stats(fit, SS_reg, SS_tot)
 end
 
 local function fit_add_predicted(t, param_name, X, fit, index_map)
@@ -112,6 +122,84 @@ local function fit_add_predicted(t, param_name, X, fit, index_map)
     end
 end
 
+-- Streaming computation of the fit. The rows of the table are
+-- evaluated in chunks and the triangular factor R of the QR
+-- decomposition of the augmented matrix [X y] is updated for each
+-- chunk. The model matrix is never stored entirely and the rank
+-- detection is done on the small R factor. A second pass over the
+-- chunks computes the residuals and, if requested, the predicted
+-- values.
+local function compute_fit_streaming(t, info, x_exprs, y_expr, index_map, chunk_size, predict)
+    local p = info.dim
+    local q = p + 1
+    local chunks = gdt_expr.index_map_chunks(index_map, chunk_size)
+
+    local R = matrix.new(q, q)
+    local W = matrix.alloc(q + chunk_size, q)
+    local tau = ffi.gc(gsl.gsl_vector_alloc(q), gsl.gsl_vector_free)
+    local tda = tonumber(W.tda)
+
+    -- the mean and the sum of squares of y are computed with Welford's
+    -- method
+    local n, y_mean, SS_tot = 0, 0, 0
+
+    for _, chunk in ipairs(chunks) do
+        local X, y = gdt_expr.eval_matrix(t, info, x_exprs, y_expr, chunk)
+        local nb = #y
+        local xtda, ytda = tonumber(X.tda), tonumber(y.tda)
+        for i = 0, q - 1 do
+            for j = 0, q - 1 do
+                W.data[i*tda + j] = (j >= i and R.data[i*q + j] or 0)
+            end
+        end
+        for i = 0, nb - 1 do
+            local y_i = y.data[i*ytda]
+            for j = 0, p - 1 do
+                W.data[(q + i)*tda + j] = X.data[i*xtda + j]
+            end
+            W.data[(q + i)*tda + p] = y_i
+            n = n + 1
+            local delta = y_i - y_mean
+            y_mean = y_mean + delta / n
+            SS_tot = SS_tot + delta * (y_i - y_mean)
+        end
+        local Wb = W:slice(1, 1, q + nb, q)
+        gsl_check(gsl.gsl_linalg_QR_decomp(Wb, tau))
+        for i = 0, q - 1 do
+            for j = i, q - 1 do
+                R.data[i*q + j] = W.data[i*tda + j]
+            end
+        end
+    end
+
+    if n < q then error('not enough data to fit the model') end
+
+    local Rx = R:slice(1, 1, p, p):copy()
+    local z = R:slice(1, q, p, 1):copy()
+    for i = 1, p - 1 do
+        for j = 0, i - 1 do Rx.data[i*p + j] = 0 end
+    end
+    local rho = R.data[p*q + p]
+
+    local c, chisq, cov, remov = linfit_rank(Rx, z, n, rho^2)
+    local fit = compute_fit_coeff(info.names, n, p, c, chisq, cov, remov)
+
+    local SS_reg = 0
+    for _, chunk in ipairs(chunks) do
+        local X, y = gdt_expr.eval_matrix(t, info, x_exprs, y_expr, chunk)
+        local y_pred = X * c
+        for k = 1, #y do
+            SS_reg = SS_reg + (y:get(k, 1) - y_pred:get(k, 1))^2
+        end
+        if predict then
+            fit_add_predicted(t, expr_print.expr(y_expr), X, fit, chunk)
+        end
+    end
+    fit.SE, fit.R2, fit.R2_adj = fit_Rsquare_stats(fit, SS_reg, SS_tot)
+
+    return fit
+end
+
 local function monomial_exists(ls, e)
     local n = #ls
     for k = 1, n do
@@ -214,19 +302,30 @@ local function lm(t, model_formula, options)
     local y_expr = schema.y
 
     local info, index_map = gdt_expr.prepare_model(t, x_exprs, y_expr, schema.conds)
-    local X, y = gdt_expr.eval_matrix(t, info, x_exprs, y_expr, index_map)
-    local fit = compute_fit(X, y, info.names)
+    local chunk_size = options and options.chunk_size
+
+    local fit
+    if chunk_size then
+        check.integer(chunk_size)
+        if chunk_size < 1 then error('chunk size should be a positive integer', 2) end
+        local predict = options and options.predict
+        fit = compute_fit_streaming(t, info, x_exprs, y_expr, index_map, chunk_size, predict)
+    else
+        local X, y = gdt_expr.eval_matrix(t, info, x_exprs, y_expr, index_map)
+        fit = compute_fit(X, y, info.names)
+
+        if options and options.predict then
+            local y_name = expr_print.expr(y_expr)
+            fit_add_predicted(t, y_name, X, fit, index_map)
+        end
 
-    if options and options.predict then
-        local y_name = expr_print.expr(y_expr)
-        fit_add_predicted(t, y_name, X, fit, index_map)
+        fit.SE, fit.R2, fit.R2_adj = fit_compute_Rsquare(fit, X, y)
     end
 
     fit.info = info
     fit.model_formula = model_formula
     fit.schema = schema
     fit.x_exprs = x_exprs
-    fit.SE, fit.R2, fit.R2_adj = fit_compute_Rsquare(fit, X, y)
     fit.eval_table = gdt.alloc(1, t:headers())
     fit.headers = t:headers()
 
@@ -50,6 +50,14 @@ local function gdt_table_get_number_unsafe(t, i, j)
     if e == GDT_VAL_NUMBER then return val.number end
 end
 
+-- the value is read in a shared gdt_value to avoid any allocation
+local shared_value = gdt_value()
+
+local function gdt_table_get_unsafe(t, i, j)
+    local e = cgdt.gdt_table_get(t, i - 1, j - 1, shared_value)
+    return extract_value(e, shared_value)
+end
+
 local function gdt_table_set_unsafe(t, i, j, val)
     local tp = type(val)
     if tp == 'number' then
@@ -395,6 +403,7 @@ gdt = {
     create = gdt_table_create,
 
     get_number_unsafe = gdt_table_get_number_unsafe,
+    get_unsafe        = gdt_table_get_unsafe,
 }
 
 return gdt
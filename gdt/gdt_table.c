@@ -6,6 +6,7 @@
 #include "gdt_table.h"
 #include "gdt_table_priv.h"
 #include "xmalloc.h"
+#include "lua-gsl/profiler.h"
 
 static inline int
 elem_is_string(const gdt_element* e)
@@ -160,8 +161,12 @@ gdt_table_new(int nb_rows, int nb_columns, int nb_rows_alloc)
 {
     if (unlikely(nb_rows < 0 || nb_columns < 0)) return NULL;
     long long sz = (long long)nb_columns * (long long)nb_rows_alloc;
+    PROFILER_ZONE_ENTER(PROFILER_ZONE_GDT);
     gdt_block *b = gdt_block_new(sz);
-    if (unlikely(b == NULL)) return NULL;
+    if (unlikely(b == NULL)) {
+        PROFILER_ZONE_LEAVE();
+        return NULL;
+    }
     gdt_block_ref(b);
 
     gdt_table *dt = xmalloc(sizeof(gdt_table));
@@ -178,6 +183,7 @@ gdt_table_new(int nb_rows, int nb_columns, int nb_rows_alloc)
 
     dt->cursor->table = dt;
 
+    PROFILER_ZONE_LEAVE();
     return dt;
 }
 
@@ -275,6 +281,7 @@ gdt_table_set_string(gdt_table *t, int i, int j, const char *s)
     gdt_element *e = &t->data[i * t->tda + j];
 
     if (likely(s != NULL)) {
+        PROFILER_ZONE_ENTER(PROFILER_ZONE_GDT);
         int str_index = gdt_index_lookup(t->strings, s);
         if (str_index < 0)
         {
@@ -288,6 +295,7 @@ gdt_table_set_string(gdt_table *t, int i, int j, const char *s)
 
         e->word.hi = TAG_STRING;
         e->word.lo = str_index;
+        PROFILER_ZONE_LEAVE();
     } else {
         e->word.hi = TAG_UNDEF;
     }
@@ -323,6 +331,8 @@ gdt_table_insert_columns(gdt_table *t, int j_in, int n)
     if (unlikely(new_block == NULL)) return (-1);
     gdt_block_ref(new_block);
 
+    PROFILER_ZONE_ENTER(PROFILER_ZONE_GDT);
+
     src = (int *) t->data;
     dst = (int *) new_block->data;
 
@@ -352,6 +362,7 @@ gdt_table_insert_columns(gdt_table *t, int j_in, int n)
 
     string_array_insert(t->headers, j_in, n);
 
+    PROFILER_ZONE_LEAVE();
     return 0;
 }
 
@@ -369,6 +380,8 @@ gdt_table_insert_rows(gdt_table *t, int i_in, int n)
         gdt_block *new_block = gdt_block_new(new_size);
 
         if (unlikely(new_block == NULL)) return (-1);
+
+        PROFILER_ZONE_ENTER(PROFILER_ZONE_GDT);
         gdt_block_ref(new_block);
 
         int * const src = (int *) t->data;
@@ -387,6 +400,8 @@ gdt_table_insert_rows(gdt_table *t, int i_in, int n)
         gdt_block_unref(t->block);
         t->block = new_block;
         t->data = new_block->data;
+
+        PROFILER_ZONE_LEAVE();
     }
     else
     {
@@ -1,4 +1,5 @@
 
+local ffi = require 'ffi'
 local bit = require 'bit'
 
 local floor, pi = math.floor, math.pi
@@ -361,3 +362,23 @@ local function redirect_plot()
 end
 
 redirect_plot()
+
+-- The native constructor of the meshes receives the address of the
+-- data of the matrices, their dimensions and their row stride since it
+-- cannot check the type of its arguments. It is kept in the registry
+-- so that it cannot be called with arbitrary addresses.
+local function mesh_matrix(m, index)
+   require 'gsl'
+   if not ffi.istype('gsl_matrix', m) then
+      error(string.format('expecting a real matrix as argument #%d', index), 3)
+   end
+   return tonumber(ffi.cast('uintptr_t', m.data)), tonumber(m.size1), tonumber(m.size2), tonumber(m.tda)
+end
+
+local mesh3d_data = debug.getregistry().__gsl_mesh3d_data
+
+function graph.mesh3d(vertices, faces, options)
+   local vd, vn, vc, vtda = mesh_matrix(vertices, 1)
+   local fd, fn, fc, ftda = mesh_matrix(faces, 2)
+   return mesh3d_data(vd, vn, vc, vtda, fd, fn, fc, ftda, options)
+end
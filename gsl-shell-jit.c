@@ -38,6 +38,9 @@
 #include "lualib.h"
 #include "luajit.h"
 #include "lua-gsl.h"
+#ifdef GSL_SHELL_BUNDLE
+#include "lua-bundle.h"
+#endif
 #include "gsl-shell.h"
 #include "completion.h"
 #include "lua-graph.h"
@@ -116,6 +119,9 @@ static void gsl_shell_openlibs(lua_State *L)
 {
     luaopen_gsl (L);
     register_graph (L);
+#ifdef GSL_SHELL_BUNDLE
+    lua_bundle_open (L);
+#endif
 }
 
 static void lstop(lua_State *L, lua_Debug *ar)
@@ -1,29 +1,53 @@
 -- load initialization files for GSL Shell
 
 require('iter')
-require('matrix')
-require('eigen')
-require('num')
-require('rng')
-require('rnd')
-require('integ-init')
-require('fft-init')
 require('graph-init')
-require('randist')
 require('import')
-require('contour')
-require('sf')
-require('help')
-require('vegas')
-require('gdt')
-require('gdt-parse-csv')
-require('gdt-hist')
-require('gdt-plot')
-require('gdt-lm')
-require('gdt-interp')
-require('linfit')
-
-num.bspline = require 'bspline'
+
+-- The other modules are loaded on demand. The global variables listed
+-- below are initially undefined and the modules that define them are
+-- loaded the first time one of them is accessed.
+local autoload_groups = {
+   {names = {'matrix', 'complex', 'matrix_lu', 'matrix_complex_lu',
+             'matrix_td_decomp', 'matrix_complex_td_decomp'},
+    modules = {'matrix'}},
+   {names = {'eigen', 'order_lookup'}, modules = {'eigen'}},
+   {names = {'num'},
+    modules = {'num', 'integ-init', 'fft-init', 'vegas', 'linfit'},
+    init = function() num.bspline = require 'bspline' end},
+   {names = {'rng'}, modules = {'rng'}},
+   {names = {'rnd'}, modules = {'rnd'}},
+   {names = {'randist'}, modules = {'randist'}},
+   {names = {'contour'}, modules = {'contour'}},
+   {names = {'sf'}, modules = {'sf'}},
+   {names = {'help'}, modules = {'help'}},
+   {names = {'profile'}, modules = {'profile'}},
+   {names = {'parallel'}, modules = {'parallel'}},
+   {names = {'gdt', 'gen_xlabels', 'add_category_legend'},
+    modules = {'gdt', 'gdt-parse-csv', 'gdt-hist', 'gdt-plot', 'gdt-lm', 'gdt-interp'}},
+}
+
+local autoload = {}
+for _, group in ipairs(autoload_groups) do
+   for _, name in ipairs(group.names) do autoload[name] = group end
+end
+
+-- the names not yet loaded are listed by the tab completion
+debug.getregistry().__gsl_autoload = autoload
+
+local function autoload_index(t, name)
+   local group = autoload[name]
+   if group then
+      -- the entries are removed before loading so that an access from
+      -- the modules themselves does not recurse
+      for _, n in ipairs(group.names) do autoload[n] = nil end
+      for _, modname in ipairs(group.modules) do require(modname) end
+      if group.init then group.init() end
+      return rawget(t, name)
+   end
+end
+
+setmetatable(_G, {__index = autoload_index})
 
 local demomod
 
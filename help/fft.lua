@@ -15,6 +15,25 @@ num.fftinv(hc[, in_place])
    of the given half-complex vector. If "in_place" is "true" then the
    original data is altered and the resulting vector will point to the
    same underlying data of the original vector.
+]],
+
+   [num.fft_many] = [[
+num.fft_many(m[, dim, in_place])
+
+   Perform the Fourier transform of each column of the matrix "m", or
+   of each row if "dim" is 2, and returns a table with the resulting
+   half-complex arrays. All the transforms share the same wavetable
+   and the arrays point to a single data block. If "in_place" is
+   "true" the data of "m" is altered.
+]],
+
+   [num.fft_cache_budget] = [[
+num.fft_cache_budget([nbytes])
+
+   Set the maximum memory used to cache the FFT wavetables and
+   workspaces for the different sizes. The least recently used
+   resources are released when the budget is exceeded. Returns the
+   previous budget.
 ]]
 }
 
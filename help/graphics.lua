@@ -136,12 +136,13 @@ graph.window([layout])
 ]],
 
   [Window.save_svg] = [[
-<window>:save_svg(filename[, width, height])
+<window>:save_svg(filename[, width, height, options])
 
    Save the content of the window in the given filename in SVG format.
    Two optional parameters can be given to specify the width and
    height of the drawing area. If the "svg" extension is not given it
-   will be automatically added.
+   will be automatically added. The optional table "options" is the
+   same accepted by the save_svg method of the plots.
 ]],
 
   [window_mt] = [[
@@ -294,12 +295,16 @@ graph.canvas([title])
 ]],
 
   [Plot'save_svg'] = [[
-<plot>:save_svg(filename[, w, h])
+<plot>:save_svg(filename[, w, h, options])
 
    Save the plot in the given filename in SVG format. Two optional
    parameters can be given to specify the width and height of the
    drawing area. If the "svg" extension is not given it will be
-   automatically added.
+   automatically added. The optional table "options" can have the
+   fields "precision", the number of decimals of the coordinates
+   (default 2), "relative", to use relative path commands, and
+   "decimate", the distance in pixels under which the vertices of a
+   line are omitted.
 ]],
 
   [Plot'set_legend'] = [[
@@ -8,6 +8,17 @@ num.integ(f, a, b[, epsabs, epsrel])
    algorithm internally.
 ]],
 
+   [num.integ_many] = [[
+num.integ_many(fs, a, b[, epsabs, epsrel, params])
+
+   Compute the definite integrals in the interval "a", "b" of all the
+   functions in the list "fs". If "fs" is a function and a list of
+   parameters "params" is given the integral of f(x, p) is computed for
+   each parameter p. Returns two column matrices with the results and
+   the estimated absolute errors. The same QAG workspace is reused for
+   all the integrals.
+]],
+
    [num.quad_prepare] = [[
 num.quad_prepare {method= <string>, order= <int>, limits= <int>}
 
@@ -95,6 +95,45 @@ matrix.fset(m, f)
    matrix that already exists instead of creating a new one.
 ]],
 
+   [matrix.expr] = [[
+matrix.expr(f, ...)
+
+   Call the function "f" with the given arguments and return the value
+   of the resulting matrix expression. The matrices passed as
+   arguments are replaced by deferred expressions so that all the
+   element-wise operations are computed in a single loop without
+   creating temporary matrices. Matrix products are computed
+   separately.
+]],
+
+   [matrix.lazy] = [[
+matrix.lazy(m)
+
+   Return a deferred expression for the matrix "m". The arithmetic
+   operations applied to the expression build a new expression that
+   can be computed with the method "eval([dest])". If "dest" is given
+   the result is stored in the existing matrix "dest".
+]],
+
+   [matrix.scope] = [[
+matrix.scope(f, ...)
+
+   Call the function "f" with the given arguments and release the
+   memory of all the matrices allocated during the call as soon as it
+   returns, except the matrices returned by "f". The released matrices
+   should not be used anymore.
+]],
+
+   [matrix.pool] = [[
+matrix.pool {limit= <int>, align= <int>}
+
+   Configure the pool that keeps the memory of released matrices for
+   reuse. "limit" is the maximum number of bytes kept in the pool and
+   "align" is the alignment in bytes of the matrix data, for example
+   64 for SIMD operations. Returns a table with the current settings
+   and the number of bytes in the pool.
+]],
+
    ['matrix'] = [[
 <real matrix>
 
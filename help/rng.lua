@@ -27,6 +27,20 @@ rng.list()
    This function returns a random integer from 0 to n-1 inclusive by
    scaling down and/or discarding samples from the generator R.  All
    integers in the range [0,n-1] are produced with equal probability.
+]],
+ 	[RNG.fill] = [[
+<rng>:fill(m)
+
+   Fill the real matrix "m" with random numbers uniformly distributed
+   in the range [0,1) and return the matrix.
+]],
+	[rng.stream] = [[
+rng.stream(seed, index[, name])
+
+   Return a new random number generator of type "name" for the
+   sub-stream "index" of the given "seed". Generators obtained with
+   the same seed and different indexes are seeded independently, so
+   that each parallel job can use its own reproducible stream.
 ]],
  	[RNG.set] = [[
 <rng>:set(seed)
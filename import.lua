@@ -46,7 +46,7 @@ local function new_env()
    end
 
    local function index(t, n)
-      local v = rawget(_G, n)
+      local v = _G[n]
       if use_strict and not v then check_declared(n) end
       return v
    end
@@ -65,7 +65,7 @@ local function new_env()
          if module_name == 'strict' then
              use_strict = true
          else
-            local m = rawget(_G, module_name)
+            local m = _G[module_name]
             if m and type(m) == 'table' then
                for k, v in pairs(m) do
                   if k ~= 'use' then rawset(lookup_env, k, v) end
@@ -1,7 +1,32 @@
-
 local template = require 'template'
 local check = require 'check'
 
+-- Each integrator generated from the qag/qng templates owns a static
+-- workspace so it cannot be reentered. The integrators are kept in free
+-- lists indexed by (method, limit, order) so that repeated or nested
+-- integrations reuse an idle instance instead of generating a new one.
+local quad_pool = {}
+
+local function quad_acquire(method, limit, order)
+   local key = string.format('%s:%d:%d', method, limit, order)
+   local free = quad_pool[key]
+   if not free then
+      free = {}
+      quad_pool[key] = free
+   end
+   local n = #free
+   if n > 0 then
+      local q = free[n]
+      free[n] = nil
+      return q, free
+   end
+   return template.load(method, {limit= limit, order= order}), free
+end
+
+local function quad_release(free, q)
+   free[#free+1] = q
+end
+
 function num.quad_prepare(options)
    local known_methods = {qng= true, qag= true}
 
@@ -16,26 +41,59 @@ function num.quad_prepare(options)
    check.integer(limit)
 
    if limit < 8 then limit = 8 end
-   
+
    local q = template.load(method, {limit= limit, order= order})
 
    return q
 end
 
-local q_default
-
 function num.integ(f, a, b, epsabs, epsrel)
    epsabs = epsabs or 1e-8
    epsrel = epsrel or 1e-8
 
    check.number(a)
    check.number(b)
-   
-   if not q_default then
-      q_default = template.load('qag', {limit= 64, order= 21})
-   end
 
-   local result = q_default (f, a, b, epsabs, epsrel)
+   local q, free = quad_acquire('qag', 64, 21)
+   local result = q (f, a, b, epsabs, epsrel)
+   quad_release(free, q)
 
    return result
 end
+
+function num.integ_many(fs, a, b, epsabs, epsrel, params)
+   epsabs = epsabs or 1e-8
+   epsrel = epsrel or 1e-8
+
+   check.number(a)
+   check.number(b)
+
+   local n, fp
+   if type(fs) == 'function' then
+      if type(params) ~= 'table' then
+         error('expecting a table of parameters for the integrand', 2)
+      end
+      -- a single closure is used for all the parameters to avoid
+      -- allocating a new function for each integral
+      local f, p = fs
+      fp = function(x) return f(x, p) end
+      fs = function(k) p = params[k]; return fp end
+      n = #params
+   else
+      local list = fs
+      fs = function(k) return list[k] end
+      n = #list
+   end
+
+   local r = matrix.alloc(n, 1)
+   local e = matrix.alloc(n, 1)
+
+   local q, free = quad_acquire('qag', 64, 21)
+   for k = 1, n do
+      local result, abserr = q (fs(k), a, b, epsabs, epsrel)
+      r.data[k-1], e.data[k-1] = result, abserr
+   end
+   quad_release(free, q)
+
+   return r, e
+end
@@ -2,19 +2,47 @@ local ffi = require 'ffi'
 local gsl = require 'gsl'
 local gsl_check = require 'gsl-check'
 
--- QR decomposition with column pivoting
-local function QRPT(A)
-    local m, n = matrix.dim(A)
-    local q = matrix.alloc(m, m)
-    local r = matrix.alloc(m, n)
-    local k = math.min(m, n)
-    local p = ffi.gc(gsl.gsl_permutation_alloc(n), gsl.gsl_permutation_free)
-    local norm = gsl.gsl_vector_alloc(n)
-    local tau = ffi.gc(gsl.gsl_vector_alloc(k), gsl.gsl_vector_free)
-    local signum = ffi.new('int[1]')
-    gsl.gsl_linalg_QRPT_decomp2(A, q, r, tau, p, signum, norm)
-    gsl.gsl_vector_free(norm)
-    return q, r, tau, p
+-- The n x n matrices and the vectors used for the factorisations are
+-- kept in a small cache indexed by the number of columns n so that
+-- repeated fits of the same size do not allocate them again. The m x n
+-- copy of the model matrix is not cached as it can be large.
+local workspace_max = 4
+local workspaces = {}
+
+local function get_workspace(n)
+    for k, ws in ipairs(workspaces) do
+        if ws.n == n then
+            -- move the workspace to the front of the list
+            table.remove(workspaces, k)
+            table.insert(workspaces, 1, ws)
+            return ws
+        end
+    end
+    local ws = {
+        n = n,
+        V = matrix.alloc(n, n),
+        QR = matrix.alloc(n, n),
+        s = ffi.gc(gsl.gsl_vector_alloc(n), gsl.gsl_vector_free),
+        work = ffi.gc(gsl.gsl_vector_alloc(n), gsl.gsl_vector_free),
+        tau = ffi.gc(gsl.gsl_vector_alloc(n), gsl.gsl_vector_free),
+        norm = ffi.gc(gsl.gsl_vector_alloc(n), gsl.gsl_vector_free),
+        p = ffi.gc(gsl.gsl_permutation_alloc(n), gsl.gsl_permutation_free),
+        signum = ffi.new('int[1]'),
+    }
+    table.insert(workspaces, 1, ws)
+    if #workspaces > workspace_max then
+        workspaces[#workspaces] = nil
+    end
+    return ws
+end
+
+-- QR decomposition with column pivoting of the r x n matrix V1t.
+-- The decomposition is done in place and only the permutation is
+-- returned as the Q and R factors are not needed.
+local function QRPT(ws, V1t, r)
+    local tau = gsl.gsl_vector_subvector(ws.tau, 0, r)
+    gsl_check(gsl.gsl_linalg_QRPT_decomp(V1t, tau, ws.p, ws.signum, ws.norm))
+    return ws.p
 end
 
 local function perm_inverse(p, i)
@@ -30,14 +58,17 @@ end
 -- with a very small ratio vs main singular value are excluded.
 -- Once rank is found QRPT is used to identify indipendent columns
 -- as described in [Golub].
-local function linfit_rank(A, b)
+-- The optional arguments "nobs" and "ssq_extra" are used when A and b
+-- are a reduced form of the original problem, like the triangular
+-- factor R and Q' y obtained from a QR decomposition. In this case
+-- "nobs" is the original number of observations and "ssq_extra" the
+-- part of the residual sum of squares not represented in A and b.
+local function linfit_rank(A, b, nobs, ssq_extra)
     local m, n = matrix.dim(A)
-    local U = matrix.copy(A)
-    local V = matrix.alloc(n, n)
-    local s = gsl.gsl_vector_alloc(n)
-    local ws = gsl.gsl_vector_alloc(n)
-    gsl_check(gsl.gsl_linalg_SV_decomp(U, V, s, ws))
-    gsl.gsl_vector_free(ws)
+    local ws = get_workspace(n)
+    local U, V, s = matrix.alloc(m, n), ws.V, ws.s
+    gsl.gsl_matrix_memcpy(U, A)
+    gsl_check(gsl.gsl_linalg_SV_decomp(U, V, s, ws.work))
 
     local r = 0
     local s_sup = s.data[0]
@@ -45,10 +76,15 @@ local function linfit_rank(A, b)
         if s.data[k - 1] / s_sup < 1e-10 then break end
         r = r + 1
     end
-    gsl.gsl_vector_free(s)
 
-    local V1t = matrix.new(r, n, |i,j| V:get(j, i))
-    local Q, R, tau, p = QRPT(V1t)
+    local V1t = ws.QR:slice(1, 1, r, n)
+    local qtda = tonumber(V1t.tda)
+    for i = 0, r - 1 do
+        for j = 0, n - 1 do
+            V1t.data[i*qtda + j] = V.data[j*n + i]
+        end
+    end
+    local p = QRPT(ws, V1t, r)
 
     -- compute the matrix K = A' A taking into account permutation "p".
     local K = matrix.alloc(r, r)
@@ -80,7 +116,7 @@ local function linfit_rank(A, b)
     local x_r = Kinv * tAb
 
     -- compute residual sum of squares
-    local ssq = 0
+    local ssq = ssq_extra or 0
     for i = 0, m - 1 do
         local y_i = 0
         for j = 0, r - 1 do
@@ -90,7 +126,7 @@ local function linfit_rank(A, b)
     end
 
     local cov = matrix.alloc(n, n)
-    local cov_fact = ssq / (m - r)
+    local cov_fact = ssq / ((nobs or m) - r)
     for i = 0, n - 1 do
         for j = 0, n - 1 do
             local ip, jp = perm_inverse(p, i), perm_inverse(p, j)
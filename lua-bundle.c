@@ -0,0 +1,63 @@
+/* lua-bundle.c
+ *
+ * Copyright (C) 2013 Francesco Abbate
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/* Lua modules precompiled to bytecode and embedded in the executable.
+   The data is generated at build time by scripts/lua-bundle.lua.
+   Each module is registered in package.preload so that "require"
+   finds it without reading and parsing the source file. */
+
+#include <lua.h>
+#include <lauxlib.h>
+
+#include "lua-bundle.h"
+
+struct bundle_entry {
+    const char *name;
+    const unsigned char *data;
+    size_t size;
+};
+
+#include "lua-bundle-data.h"
+
+static int
+bundle_loader (lua_State *L)
+{
+    const struct bundle_entry *e = lua_touserdata(L, lua_upvalueindex(1));
+    const char *name = luaL_checkstring(L, 1);
+    if (luaL_loadbuffer(L, (const char *) e->data, e->size, e->name) != 0)
+        return lua_error(L);
+    lua_pushstring(L, name);
+    lua_call(L, 1, 1);
+    return 1;
+}
+
+void
+lua_bundle_open (lua_State *L)
+{
+    const struct bundle_entry *e;
+
+    lua_getglobal(L, "package");
+    lua_getfield(L, -1, "preload");
+    for (e = bundle_entries; e->name; e++) {
+        lua_pushlightuserdata(L, (void *) e);
+        lua_pushcclosure(L, bundle_loader, 1);
+        lua_setfield(L, -2, e->name);
+    }
+    lua_pop(L, 2);
+}
@@ -0,0 +1,14 @@
+#ifndef LUA_BUNDLE_H
+#define LUA_BUNDLE_H
+
+#include "defs.h"
+
+__BEGIN_DECLS
+
+#include <lua.h>
+
+extern void lua_bundle_open (lua_State *L);
+
+__END_DECLS
+
+#endif
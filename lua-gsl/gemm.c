@@ -0,0 +1,218 @@
+/* gemm.c
+ *
+ * Copyright (C) 2013 Francesco Abbate
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <string.h>
+#include <pthread.h>
+
+#include "gemm.h"
+#include "parallel.h"
+
+/* The columns of B and C are taken in blocks of GEMM_NB and the inner
+   dimension in blocks of GEMM_KB so that a block of B stays in the
+   L2 cache while it is used for all the rows of C. Four rows of C are
+   updated together to reuse each load of B, the inner loops run along
+   the rows and are vectorized by the compiler. */
+#define GEMM_KB 128
+#define GEMM_NB 256
+
+/* products smaller than this number of multiplications are done in
+   the calling thread */
+#define GEMM_THREAD_MIN (1 << 21)
+#define GEMM_MAX_THREADS 16
+
+struct gemm_job {
+    int complex;
+    int m, n, k;
+    const double *a, *b;
+    double *c;
+    int lda, ldb, ldc;
+    int i0, i1;
+};
+
+static void
+dgemm_rows (const struct gemm_job *job)
+{
+    const int lda = job->lda, ldb = job->ldb, ldc = job->ldc;
+    int i, j, p, jb, pb;
+
+    for (i = job->i0; i < job->i1; i++)
+        memset (job->c + i * ldc, 0, job->n * sizeof(double));
+
+    for (pb = 0; pb < job->k; pb += GEMM_KB)
+    {
+        const int pe = (pb + GEMM_KB < job->k ? pb + GEMM_KB : job->k);
+        for (jb = 0; jb < job->n; jb += GEMM_NB)
+        {
+            const int nj = (jb + GEMM_NB < job->n ? GEMM_NB : job->n - jb);
+            for (i = job->i0; i + 4 <= job->i1; i += 4)
+            {
+                double * __restrict c0 = job->c + i * ldc + jb;
+                double * __restrict c1 = c0 + ldc;
+                double * __restrict c2 = c1 + ldc;
+                double * __restrict c3 = c2 + ldc;
+                const double *a0 = job->a + i * lda;
+                for (p = pb; p < pe; p++)
+                {
+                    const double * __restrict bp = job->b + p * ldb + jb;
+                    const double x0 = a0[p], x1 = a0[lda + p];
+                    const double x2 = a0[2*lda + p], x3 = a0[3*lda + p];
+                    for (j = 0; j < nj; j++)
+                    {
+                        const double y = bp[j];
+                        c0[j] += x0 * y;
+                        c1[j] += x1 * y;
+                        c2[j] += x2 * y;
+                        c3[j] += x3 * y;
+                    }
+                }
+            }
+            for (; i < job->i1; i++)
+            {
+                double * __restrict c0 = job->c + i * ldc + jb;
+                const double *a0 = job->a + i * lda;
+                for (p = pb; p < pe; p++)
+                {
+                    const double * __restrict bp = job->b + p * ldb + jb;
+                    const double x0 = a0[p];
+                    for (j = 0; j < nj; j++)
+                        c0[j] += x0 * bp[j];
+                }
+            }
+        }
+    }
+}
+
+static void
+zgemm_rows (const struct gemm_job *job)
+{
+    const int lda = 2 * job->lda, ldb = 2 * job->ldb, ldc = 2 * job->ldc;
+    int i, j, p, jb, pb;
+
+    for (i = job->i0; i < job->i1; i++)
+        memset (job->c + i * ldc, 0, 2 * job->n * sizeof(double));
+
+    for (pb = 0; pb < job->k; pb += GEMM_KB)
+    {
+        const int pe = (pb + GEMM_KB < job->k ? pb + GEMM_KB : job->k);
+        for (jb = 0; jb < job->n; jb += GEMM_NB / 2)
+        {
+            const int nj = (jb + GEMM_NB / 2 < job->n ? GEMM_NB / 2 : job->n - jb);
+            for (i = job->i0; i < job->i1; i++)
+            {
+                double * __restrict c0 = job->c + i * ldc + 2 * jb;
+                const double *a0 = job->a + i * lda;
+                for (p = pb; p < pe; p++)
+                {
+                    const double * __restrict bp = job->b + p * ldb + 2 * jb;
+                    const double xr = a0[2*p], xi = a0[2*p + 1];
+                    for (j = 0; j < nj; j++)
+                    {
+                        const double yr = bp[2*j], yi = bp[2*j + 1];
+                        c0[2*j]     += xr * yr - xi * yi;
+                        c0[2*j + 1] += xr * yi + xi * yr;
+                    }
+                }
+            }
+        }
+    }
+}
+
+static void *
+gemm_thread (void *data)
+{
+    const struct gemm_job *job = data;
+    if (job->complex)
+        zgemm_rows (job);
+    else
+        dgemm_rows (job);
+    return NULL;
+}
+
+static int
+gemm_threads (int nthreads, double work, int m)
+{
+    if (work < GEMM_THREAD_MIN)
+        return 1;
+    if (nthreads < 1)
+        nthreads = parallel_cpu_count ();
+    if (nthreads > GEMM_MAX_THREADS)
+        nthreads = GEMM_MAX_THREADS;
+    /* each thread should have at least a group of four rows */
+    if (nthreads > m / 4)
+        nthreads = (m >= 4 ? m / 4 : 1);
+    return nthreads;
+}
+
+/* The rows of C are divided in contiguous ranges, one for each
+   thread. The calling thread computes the first range. */
+static void
+gemm_run (struct gemm_job *job, int nthreads)
+{
+    struct gemm_job jobs[GEMM_MAX_THREADS];
+    pthread_t threads[GEMM_MAX_THREADS];
+    int started[GEMM_MAX_THREADS];
+    const int m = job->m;
+    int t;
+
+    if (nthreads <= 1)
+    {
+        job->i0 = 0;
+        job->i1 = m;
+        gemm_thread (job);
+        return;
+    }
+
+    for (t = 0; t < nthreads; t++)
+    {
+        jobs[t] = *job;
+        jobs[t].i0 = ((long) m * t / nthreads) & ~3;
+        jobs[t].i1 = (t + 1 < nthreads ? ((long) m * (t + 1) / nthreads) & ~3 : m);
+    }
+
+    for (t = 1; t < nthreads; t++)
+        started[t] = (pthread_create (&threads[t], NULL, gemm_thread, &jobs[t]) == 0);
+
+    gemm_thread (&jobs[0]);
+
+    /* the ranges of the threads that could not be created are
+       computed by the calling thread */
+    for (t = 1; t < nthreads; t++)
+    {
+        if (started[t])
+            pthread_join (threads[t], NULL);
+        else
+            gemm_thread (&jobs[t]);
+    }
+}
+
+void
+gs_dgemm (int m, int n, int k, const double *a, int lda,
+          const double *b, int ldb, double *c, int ldc, int nthreads)
+{
+    struct gemm_job job = {0, m, n, k, a, b, c, lda, ldb, ldc, 0, 0};
+    gemm_run (&job, gemm_threads (nthreads, (double) m * n * k, m));
+}
+
+void
+gs_zgemm (int m, int n, int k, const double *a, int lda,
+          const double *b, int ldb, double *c, int ldc, int nthreads)
+{
+    struct gemm_job job = {1, m, n, k, a, b, c, lda, ldb, ldc, 0, 0};
+    gemm_run (&job, gemm_threads (nthreads, 4.0 * m * n * k, m));
+}
@@ -0,0 +1,41 @@
+/* gemm.h
+ *
+ * Copyright (C) 2013 Francesco Abbate
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef GEMM_H
+#define GEMM_H
+
+#include "defs.h"
+
+__BEGIN_DECLS
+
+/* Cache-blocked matrix products C = A B for row-major matrices, used
+   by the Lua matrix module through the FFI when no optimized CBLAS
+   library is available. The complex matrices are stored as pairs of
+   doubles and their leading dimensions are given in complex
+   elements. The rows of C are split between "nthreads" threads for
+   large products, a value less than one selects the number of
+   processors. */
+extern void gs_dgemm (int m, int n, int k, const double *a, int lda,
+                      const double *b, int ldb, double *c, int ldc, int nthreads);
+extern void gs_zgemm (int m, int n, int k, const double *a, int lda,
+                      const double *b, int ldb, double *c, int ldc, int nthreads);
+
+__END_DECLS
+
+#endif
@@ -12,6 +12,7 @@
 #define GS_DRAW_SCALABLE_NAME_DEF NULL
 #define GS_DRAW_PATH_NAME_DEF   "GSL.path"
 #define GS_DRAW_ELLIPSE_NAME_DEF   "GSL.ellipse"
+#define GS_DRAW_MESH3D_NAME_DEF "GSL.mesh3d"
 #define GS_DRAW_DRAWABLE_NAME_DEF NULL
 #define GS_DRAW_TEXT_NAME_DEF   "GSL.text"
 #define GS_DRAW_TEXTSHAPE_NAME_DEF "GSL.textshape"
@@ -31,6 +32,7 @@ const struct gs_type gs_type_table[] = {
   MY_EXPAND(DRAW_SCALABLE, "graphical object"),
   MY_EXPAND_DER(DRAW_PATH, "geometric line", DRAW_SCALABLE),
   MY_EXPAND_DER(DRAW_ELLIPSE, "geometric ellipse", DRAW_SCALABLE),
+  MY_EXPAND_DER(DRAW_MESH3D, "3D mesh", DRAW_SCALABLE),
   MY_EXPAND(DRAW_DRAWABLE, "window graphical object"),
   MY_EXPAND_DER(DRAW_TEXT, "graphical text", DRAW_DRAWABLE),
   MY_EXPAND_DER(DRAW_TEXTSHAPE, "geometric text shape", DRAW_DRAWABLE),
@@ -14,6 +14,7 @@ enum gs_type_e {
   GS_DRAW_SCALABLE, /* derived types are declared only after their base class */
   GS_DRAW_PATH,
   GS_DRAW_ELLIPSE,
+  GS_DRAW_MESH3D,
   GS_DRAW_DRAWABLE,
   GS_DRAW_TEXT,
   GS_DRAW_TEXTSHAPE,
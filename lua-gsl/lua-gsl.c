@@ -28,6 +28,9 @@
 #include "gs-types.h"
 #include "lua-utils.h"
 #include "fatal.h"
+#include "profiler.h"
+#include "gemm.h"
+#include "parallel.h"
 
 #include "gdt/gdt_table.h"
 
@@ -36,6 +39,12 @@
 extern gdt_table *(*_gdt_ref)(int nb_rows, int nb_columns, int nb_rows_alloc);
 gdt_table *(*_gdt_ref)(int nb_rows, int nb_columns, int nb_rows_alloc) = gdt_table_new;
 
+/* the matrix products are only called through the FFI */
+extern void (*_gemm_ref)(int m, int n, int k, const double *a, int lda,
+                         const double *b, int ldb, double *c, int ldc, int nthreads);
+void (*_gemm_ref)(int m, int n, int k, const double *a, int lda,
+                  const double *b, int ldb, double *c, int ldc, int nthreads) = gs_zgemm;
+
 struct gsl_shell_state* global_state;
 
 void
@@ -73,5 +82,8 @@ luaopen_gsl (lua_State *L)
   lua_pushcfunction (L, gs_type_string);
   lua_setfield (L, LUA_REGISTRYINDEX, "__gsl_type");
 
+  profiler_register (L);
+  parallel_register (L);
+
   return 0;
 }
@@ -0,0 +1,414 @@
+/* parallel.c
+ *
+ * Copyright (C) 2013 Francesco Abbate
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/* Pool of worker threads for the parallel module. Each worker has its
+   own Lua state, created with the same libraries and module paths of
+   the main state, where the module "parallel-worker" is loaded. A job
+   is made of a number of tasks, each task calls in a worker the
+   function returned by the module with the task index, the number of
+   tasks and the arguments of the job. The arguments can be only nil,
+   booleans, numbers or strings and they are copied in a C array
+   before the job starts so that the workers never access the main
+   state. The matrices are shared by passing the address of their
+   data. The main thread waits for the completion of all the tasks. */
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <lua.h>
+#include <lauxlib.h>
+#include <lualib.h>
+
+#include "parallel.h"
+#include "lua-gsl.h"
+
+#define PARALLEL_MAX_WORKERS 64
+
+enum { ARG_NIL = 0, ARG_BOOLEAN, ARG_NUMBER, ARG_STRING };
+
+struct task_arg {
+    int type;
+    double number;
+    const char *str;
+    size_t len;
+};
+
+struct parallel_job {
+    int nargs;
+    const struct task_arg *args;
+    int ntasks;
+    int next_task;
+    int completed;
+    double *results;
+    char *has_result;
+    char *error;
+};
+
+static struct {
+    int nworkers;
+    lua_State *states[PARALLEL_MAX_WORKERS];
+    pthread_t threads[PARALLEL_MAX_WORKERS];
+    pthread_mutex_t mutex;
+    pthread_cond_t work_cond;
+    pthread_cond_t done_cond;
+    struct parallel_job *job;
+} pool;
+
+int
+parallel_cpu_count (void)
+{
+#ifdef WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (info.dwNumberOfProcessors > 0 ? info.dwNumberOfProcessors : 1);
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return (n > 0 ? n : 1);
+#endif
+}
+
+static void
+push_arg (lua_State *W, const struct task_arg *a)
+{
+    switch (a->type)
+    {
+    case ARG_BOOLEAN:
+        lua_pushboolean(W, a->number != 0);
+        break;
+    case ARG_NUMBER:
+        lua_pushnumber(W, a->number);
+        break;
+    case ARG_STRING:
+        lua_pushlstring(W, a->str, a->len);
+        break;
+    default:
+        lua_pushnil(W);
+    }
+}
+
+static void
+run_task (lua_State *W, struct parallel_job *job, int k)
+{
+    int i;
+    lua_getfield(W, LUA_REGISTRYINDEX, "__gsl_parallel_task");
+    lua_pushinteger(W, k + 1);
+    lua_pushinteger(W, job->ntasks);
+    for (i = 0; i < job->nargs; i++)
+        push_arg(W, &job->args[i]);
+
+    if (lua_pcall(W, job->nargs + 2, 1, 0) != 0)
+    {
+        const char *msg = lua_tostring(W, -1);
+        pthread_mutex_lock(&pool.mutex);
+        if (!job->error)
+            job->error = strdup(msg ? msg : "error in parallel task");
+        pthread_mutex_unlock(&pool.mutex);
+    }
+    else if (lua_isnumber(W, -1))
+    {
+        job->results[k] = lua_tonumber(W, -1);
+        job->has_result[k] = 1;
+    }
+    lua_settop(W, 0);
+}
+
+static void *
+worker_thread (void *data)
+{
+    lua_State *W = data;
+
+    pthread_mutex_lock(&pool.mutex);
+    for (;;)
+    {
+        struct parallel_job *job = pool.job;
+        if (job && job->next_task < job->ntasks)
+        {
+            int k = job->next_task++;
+            pthread_mutex_unlock(&pool.mutex);
+            /* once a task failed the others are skipped */
+            if (!job->error)
+                run_task(W, job, k);
+            pthread_mutex_lock(&pool.mutex);
+            if (++job->completed == job->ntasks)
+                pthread_cond_signal(&pool.done_cond);
+        }
+        else
+        {
+            pthread_cond_wait(&pool.work_cond, &pool.mutex);
+        }
+    }
+    return NULL;
+}
+
+/* copy the string field "key" of the table at the top of L into the
+   table at the top of W */
+static void
+copy_string_field (lua_State *L, lua_State *W, const char *key)
+{
+    lua_getfield(L, -1, key);
+    if (lua_isstring(L, -1))
+    {
+        lua_pushstring(W, lua_tostring(L, -1));
+        lua_setfield(W, -2, key);
+    }
+    lua_pop(L, 1);
+}
+
+/* The C loaders in package.preload, like the ones of the modules
+   embedded in the executable, are copied with their light userdata
+   upvalue. */
+static void
+copy_preload (lua_State *L, lua_State *W)
+{
+    lua_getfield(L, -1, "preload");
+    lua_getfield(W, -1, "preload");
+    lua_pushnil(L);
+    while (lua_next(L, -2) != 0)
+    {
+        if (lua_type(L, -2) == LUA_TSTRING && lua_iscfunction(L, -1))
+        {
+            lua_CFunction f = lua_tocfunction(L, -1);
+            int nup = 0;
+            if (lua_getupvalue(L, -1, 1))
+            {
+                if (lua_islightuserdata(L, -1))
+                {
+                    lua_pushlightuserdata(W, lua_touserdata(L, -1));
+                    nup = 1;
+                }
+                lua_pop(L, 1);
+            }
+            lua_pushcclosure(W, f, nup);
+            lua_setfield(W, -2, lua_tostring(L, -2));
+        }
+        lua_pop(L, 1);
+    }
+    lua_pop(L, 1);
+    lua_pop(W, 1);
+}
+
+/* Create the state of a worker. On error the message is pushed on L
+   and NULL is returned. */
+static lua_State *
+worker_state_new (lua_State *L)
+{
+    lua_State *W = luaL_newstate();
+    if (W == NULL)
+    {
+        lua_pushstring(L, "cannot create state: not enough memory");
+        return NULL;
+    }
+
+    luaL_openlibs(W);
+    luaopen_gsl(W);
+
+    lua_getglobal(L, "package");
+    lua_getglobal(W, "package");
+    copy_string_field(L, W, "path");
+    copy_string_field(L, W, "cpath");
+    copy_preload(L, W);
+    lua_pop(W, 1);
+    lua_pop(L, 1);
+
+    lua_pushboolean(W, 1);
+    lua_setfield(W, LUA_REGISTRYINDEX, "__gsl_parallel_worker");
+
+    lua_getglobal(W, "require");
+    lua_pushstring(W, "parallel-worker");
+    if (lua_pcall(W, 1, 1, 0) != 0)
+    {
+        lua_pushstring(L, lua_tostring(W, -1));
+        lua_close(W);
+        return NULL;
+    }
+    lua_getfield(W, -1, "task");
+    lua_setfield(W, LUA_REGISTRYINDEX, "__gsl_parallel_task");
+    lua_settop(W, 0);
+    return W;
+}
+
+/* parallel.start([n]): start the pool with n workers, by default one
+   for each processor. The pool cannot be resized once started.
+   Return the number of workers. */
+static int
+parallel_start (lua_State *L)
+{
+    int n = luaL_optinteger(L, 1, 0);
+    int k;
+
+    lua_getfield(L, LUA_REGISTRYINDEX, "__gsl_parallel_worker");
+    if (lua_toboolean(L, -1))
+        return luaL_error(L, "the parallel workers cannot start other workers");
+    lua_pop(L, 1);
+
+    if (pool.nworkers > 0)
+    {
+        lua_pushinteger(L, pool.nworkers);
+        return 1;
+    }
+
+    if (n <= 0)
+        n = parallel_cpu_count();
+    if (n > PARALLEL_MAX_WORKERS)
+        n = PARALLEL_MAX_WORKERS;
+
+    /* the states are created first so that an error in the loading of
+       the modules is reported before any thread is started */
+    for (k = 0; k < n; k++)
+    {
+        pool.states[k] = worker_state_new(L);
+        if (pool.states[k] == NULL)
+        {
+            while (--k >= 0)
+                lua_close(pool.states[k]);
+            return lua_error(L);
+        }
+    }
+
+    pthread_mutex_init(&pool.mutex, NULL);
+    pthread_cond_init(&pool.work_cond, NULL);
+    pthread_cond_init(&pool.done_cond, NULL);
+
+    for (k = 0; k < n; k++)
+    {
+        if (pthread_create(&pool.threads[k], NULL, worker_thread, pool.states[k]) != 0)
+            break;
+        pthread_detach(pool.threads[k]);
+    }
+    /* the states whose thread could not be started are discarded */
+    pool.nworkers = k;
+    for (; k < n; k++)
+        lua_close(pool.states[k]);
+
+    if (pool.nworkers == 0)
+        return luaL_error(L, "cannot start the parallel workers");
+
+    lua_pushinteger(L, pool.nworkers);
+    return 1;
+}
+
+static int
+parallel_workers (lua_State *L)
+{
+    lua_pushinteger(L, pool.nworkers);
+    return 1;
+}
+
+/* parallel.run(ntasks, ...): run the tasks in the workers with the
+   given arguments and return a table with the number returned by each
+   task, if any. */
+static int
+parallel_run (lua_State *L)
+{
+    struct parallel_job job[1];
+    struct task_arg *args;
+    int ntasks = luaL_checkinteger(L, 1);
+    int nargs = lua_gettop(L) - 1;
+    int i;
+
+    if (pool.nworkers == 0)
+        return luaL_error(L, "the parallel workers are not started");
+    if (ntasks <= 0)
+        return luaL_error(L, "invalid number of tasks");
+
+    args = lua_newuserdata(L, nargs * sizeof(struct task_arg) + 1);
+    for (i = 0; i < nargs; i++)
+    {
+        struct task_arg *a = &args[i];
+        int index = i + 2;
+        switch (lua_type(L, index))
+        {
+        case LUA_TNIL:
+            a->type = ARG_NIL;
+            break;
+        case LUA_TBOOLEAN:
+            a->type = ARG_BOOLEAN;
+            a->number = lua_toboolean(L, index);
+            break;
+        case LUA_TNUMBER:
+            a->type = ARG_NUMBER;
+            a->number = lua_tonumber(L, index);
+            break;
+        case LUA_TSTRING:
+            a->type = ARG_STRING;
+            a->str = lua_tolstring(L, index, &a->len);
+            break;
+        default:
+            return luaL_error(L, "invalid argument #%d for the parallel tasks: %s",
+                              index, luaL_typename(L, index));
+        }
+    }
+
+    job->nargs = nargs;
+    job->args = args;
+    job->ntasks = ntasks;
+    job->next_task = 0;
+    job->completed = 0;
+    job->results = lua_newuserdata(L, ntasks * sizeof(double));
+    job->has_result = lua_newuserdata(L, ntasks);
+    memset(job->has_result, 0, ntasks);
+    job->error = NULL;
+
+    pthread_mutex_lock(&pool.mutex);
+    pool.job = job;
+    pthread_cond_broadcast(&pool.work_cond);
+    while (job->completed < ntasks)
+        pthread_cond_wait(&pool.done_cond, &pool.mutex);
+    pool.job = NULL;
+    pthread_mutex_unlock(&pool.mutex);
+
+    if (job->error)
+    {
+        lua_pushstring(L, job->error);
+        free(job->error);
+        return lua_error(L);
+    }
+
+    lua_createtable(L, ntasks, 0);
+    for (i = 0; i < ntasks; i++)
+    {
+        if (job->has_result[i])
+        {
+            lua_pushnumber(L, job->results[i]);
+            lua_rawseti(L, -2, i + 1);
+        }
+    }
+    return 1;
+}
+
+static const struct luaL_Reg parallel_functions[] = {
+    {"start",   parallel_start},
+    {"workers", parallel_workers},
+    {"run",     parallel_run},
+    {NULL, NULL}
+};
+
+void
+parallel_register (lua_State *L)
+{
+    lua_newtable(L);
+    luaL_register(L, NULL, parallel_functions);
+    lua_setfield(L, LUA_REGISTRYINDEX, "__gsl_parallel");
+}
@@ -0,0 +1,36 @@
+/* parallel.h
+ *
+ * Copyright (C) 2013 Francesco Abbate
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include "defs.h"
+
+__BEGIN_DECLS
+
+struct lua_State;
+
+/* number of processors available, at least one */
+extern int  parallel_cpu_count (void);
+
+extern void parallel_register (struct lua_State *L);
+
+__END_DECLS
+
+#endif
@@ -0,0 +1,237 @@
+/* profiler.c
+ *
+ * Copyright (C) 2013 Francesco Abbate
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/* Sampling profiler for Lua scripts. A timer signal is used to take
+   the samples. When the signal is received by the thread running Lua
+   a count hook is installed, like it is done by lstop for the
+   interruption, and the Lua stack is recorded by the hook. The samples
+   taken while the thread is executing a C subsystem, like the AGG
+   rendering or the gdt tables, are attributed to a pseudo frame named
+   after the subsystem. The samples received by other threads, like
+   the window threads, are only counted for each subsystem.
+
+   Note that with the JIT compiler enabled the hook is called only
+   when the execution returns to the interpreter so the samples taken
+   in compiled code may be attributed to a later point. */
+
+#include <string.h>
+#include <signal.h>
+#include <pthread.h>
+#ifndef WIN32
+#include <sys/time.h>
+#endif
+
+#include <lua.h>
+#include <lauxlib.h>
+
+#include "profiler.h"
+
+__thread int profiler_zone = PROFILER_ZONE_LUA;
+
+static const char * const zone_names[PROFILER_ZONE_COUNT] = {"lua", "agg", "gdt"};
+
+#define PROFILER_MAX_DEPTH 64
+
+static lua_State *profiler_L;
+static pthread_t profiler_thread;
+static volatile sig_atomic_t profiler_running = 0;
+static volatile sig_atomic_t pending_samples = 0;
+static volatile sig_atomic_t pending_zone = PROFILER_ZONE_LUA;
+static volatile sig_atomic_t other_samples[PROFILER_ZONE_COUNT];
+
+static void
+profiler_hook (lua_State *L, lua_Debug *ar)
+{
+    lua_Debug info;
+    luaL_Buffer b;
+    int samples = pending_samples, zone = pending_zone;
+    int depth, level;
+
+    (void) ar;
+    pending_samples = 0;
+    pending_zone = PROFILER_ZONE_LUA;
+    lua_sethook(L, NULL, 0, 0);
+
+    if (samples == 0)
+        return;
+
+    for (depth = 0; depth < PROFILER_MAX_DEPTH; depth++)
+    {
+        if (!lua_getstack(L, depth, &info))
+            break;
+    }
+
+    /* the frames are given from the outermost to the innermost and
+       separated by a semicolon like in the "collapsed stack" format */
+    luaL_buffinit(L, &b);
+    for (level = depth - 1; level >= 0; level--)
+    {
+        lua_getstack(L, level, &info);
+        lua_getinfo(L, "Sn", &info);
+        if (info.name == NULL)
+            info.name = (strcmp(info.what, "main") == 0 ? "main" : "?");
+        lua_pushfstring(L, "%s@%s:%d", info.name, info.short_src, info.linedefined);
+        luaL_addvalue(&b);
+        if (level > 0)
+            luaL_addchar(&b, ';');
+    }
+    if (zone != PROFILER_ZONE_LUA)
+    {
+        luaL_addstring(&b, ";[");
+        luaL_addstring(&b, zone_names[zone]);
+        luaL_addchar(&b, ']');
+    }
+    luaL_pushresult(&b);
+
+    lua_getfield(L, LUA_REGISTRYINDEX, "GSL.profiler.samples");
+    lua_pushvalue(L, -2);
+    lua_rawget(L, -2);
+    samples += lua_tointeger(L, -1);
+    lua_pop(L, 1);
+    lua_pushvalue(L, -2);
+    lua_pushinteger(L, samples);
+    lua_rawset(L, -3);
+    lua_pop(L, 2);
+}
+
+static void
+profiler_signal (int sig)
+{
+    (void) sig;
+    if (!profiler_running)
+        return;
+
+    if (pthread_equal(pthread_self(), profiler_thread))
+    {
+        pending_samples++;
+        if (profiler_zone != PROFILER_ZONE_LUA)
+            pending_zone = profiler_zone;
+        /* do not replace another hook like lstop */
+        if (lua_gethook(profiler_L) == NULL)
+            lua_sethook(profiler_L, profiler_hook, LUA_MASKCOUNT, 1);
+    }
+    else
+    {
+        other_samples[profiler_zone]++;
+    }
+}
+
+#ifndef WIN32
+static void
+set_timer (int usec)
+{
+    struct itimerval t;
+    t.it_interval.tv_sec = usec / 1000000;
+    t.it_interval.tv_usec = usec % 1000000;
+    t.it_value = t.it_interval;
+    setitimer(ITIMER_PROF, &t, NULL);
+}
+#endif
+
+static int
+profiler_start (lua_State *L)
+{
+#ifdef WIN32
+    return luaL_error(L, "the profiler is not supported on this platform");
+#else
+    int usec = luaL_optinteger(L, 1, 1000);
+    struct sigaction sa;
+    int k;
+
+    if (usec <= 0)
+        return luaL_error(L, "invalid sampling interval");
+
+    if (profiler_running)
+        return luaL_error(L, "the profiler is already running");
+
+    lua_newtable(L);
+    lua_setfield(L, LUA_REGISTRYINDEX, "GSL.profiler.samples");
+    for (k = 0; k < PROFILER_ZONE_COUNT; k++)
+        other_samples[k] = 0;
+    pending_samples = 0;
+    pending_zone = PROFILER_ZONE_LUA;
+
+    profiler_L = L;
+    profiler_thread = pthread_self();
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = profiler_signal;
+    sa.sa_flags = SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGPROF, &sa, NULL);
+
+    profiler_running = 1;
+    set_timer(usec);
+    return 0;
+#endif
+}
+
+static int
+profiler_stop (lua_State *L)
+{
+#ifndef WIN32
+    if (profiler_running)
+    {
+        set_timer(0);
+        profiler_running = 0;
+        if (lua_gethook(L) == profiler_hook)
+            lua_sethook(L, NULL, 0, 0);
+        signal(SIGPROF, SIG_DFL);
+    }
+#endif
+    return 0;
+}
+
+static int
+profiler_samples (lua_State *L)
+{
+    lua_getfield(L, LUA_REGISTRYINDEX, "GSL.profiler.samples");
+    return 1;
+}
+
+/* return the number of samples taken by the other threads for each
+   subsystem */
+static int
+profiler_zones (lua_State *L)
+{
+    int k;
+    lua_newtable(L);
+    for (k = 0; k < PROFILER_ZONE_COUNT; k++)
+    {
+        lua_pushinteger(L, other_samples[k]);
+        lua_setfield(L, -2, zone_names[k]);
+    }
+    return 1;
+}
+
+static const struct luaL_Reg profiler_functions[] = {
+    {"start",   profiler_start},
+    {"stop",    profiler_stop},
+    {"samples", profiler_samples},
+    {"zones",   profiler_zones},
+    {NULL, NULL}
+};
+
+void
+profiler_register (lua_State *L)
+{
+    lua_newtable(L);
+    luaL_register(L, NULL, profiler_functions);
+    lua_setfield(L, LUA_REGISTRYINDEX, "__gsl_profiler");
+}
@@ -0,0 +1,61 @@
+/* profiler.h
+ *
+ * Copyright (C) 2013 Francesco Abbate
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "defs.h"
+
+__BEGIN_DECLS
+
+/* The subsystems to which the samples of the profiler are attributed.
+   Each thread keeps track of the subsystem it is executing with the
+   thread-local variable profiler_zone. Setting it costs just a store
+   so the zones are always compiled in, even when the profiler is not
+   running. */
+enum profiler_zone_e {
+    PROFILER_ZONE_LUA = 0,
+    PROFILER_ZONE_AGG,
+    PROFILER_ZONE_GDT,
+    PROFILER_ZONE_COUNT
+};
+
+extern __thread int profiler_zone;
+
+#define PROFILER_ZONE_ENTER(z) int profiler_zone_saved_ = profiler_zone; profiler_zone = (z)
+#define PROFILER_ZONE_LEAVE() profiler_zone = profiler_zone_saved_
+
+struct lua_State;
+
+extern void profiler_register (struct lua_State *L);
+
+__END_DECLS
+
+#ifdef __cplusplus
+/* set the profiler zone for the lifetime of the object */
+class profiler_zone_scope {
+public:
+    profiler_zone_scope(int zone): m_saved(profiler_zone) { profiler_zone = zone; }
+    ~profiler_zone_scope() { profiler_zone = m_saved; }
+private:
+    int m_saved;
+};
+#endif
+
+#endif
@@ -0,0 +1,205 @@
+local ffi = require 'ffi'
+
+local format, concat = string.format, table.concat
+local unpack, select = unpack, select
+local tonumber = tonumber
+
+local gsl_matrix         = ffi.typeof('gsl_matrix')
+local gsl_matrix_complex = ffi.typeof('gsl_matrix_complex')
+
+-- Deferred matrix expressions. The arithmetic operators applied to an
+-- expression node do not compute anything but build a tree. When the
+-- tree is evaluated all the element-wise operations are fused in a
+-- single loop over the result so that no temporary matrix is created.
+-- Matrix products and powers are not element-wise and act as barriers:
+-- their operands are evaluated and the product is computed with BLAS.
+
+local expr_mt = {}
+
+local function is_expr(x)
+   return getmetatable(x) == expr_mt
+end
+
+local function is_matrix(x)
+   return ffi.istype(gsl_matrix, x) or ffi.istype(gsl_matrix_complex, x)
+end
+
+local function expr_leaf(m)
+   local n1, n2 = tonumber(m.size1), tonumber(m.size2)
+   return setmetatable({m = m, n1 = n1, n2 = n2}, expr_mt)
+end
+
+-- convert an operand to an expression node, scalars are left unchanged
+local function operand(x)
+   if is_expr(x) then return x end
+   if is_matrix(x) then return expr_leaf(x) end
+   if type(x) == 'number' or ffi.istype('complex', x) then return x end
+   error('invalid operand in matrix expression', 3)
+end
+
+local function expr_op(op, a, b)
+   local e = setmetatable({op = op, a = a, b = b}, expr_mt)
+   local ref = is_expr(a) and a or b
+   e.n1, e.n2 = ref.n1, ref.n2
+   return e
+end
+
+-- evaluate an expression using the ordinary matrix operators
+local function interp(e)
+   if not is_expr(e) then return e end
+   if e.m then return e.m end
+   local op, a, b = e.op, interp(e.a), interp(e.b)
+   if     op == '+' then return a + b
+   elseif op == '-' then return a - b
+   elseif op == '*' then return a * b
+   elseif op == '/' then return a / b
+   else                  return -a end
+end
+
+-- true if all the leaves are real matrices and all the scalars are
+-- real numbers
+local function is_real_expr(e)
+   if type(e) == 'number' then return true end
+   if not is_expr(e) then return false end
+   if e.m then return ffi.istype(gsl_matrix, e.m) end
+   return is_real_expr(e.a) and (e.b == nil or is_real_expr(e.b))
+end
+
+local function gen_term(e, ctx)
+   if type(e) == 'number' then
+      -- scalars are passed as arguments so that the generated kernel
+      -- can be reused when only their values change
+      local k = #ctx.scalars + 1
+      ctx.scalars[k] = e
+      return 's' .. k
+   elseif e.m then
+      local k = ctx.index[e.m]
+      if not k then
+         k = #ctx.matrices + 1
+         ctx.matrices[k] = e.m
+         ctx.index[e.m] = k
+      end
+      return format('d%i[i*t%i+j]', k, k)
+   elseif e.op == 'neg' then
+      return '(-' .. gen_term(e.a, ctx) .. ')'
+   else
+      return '(' .. gen_term(e.a, ctx) .. e.op .. gen_term(e.b, ctx) .. ')'
+   end
+end
+
+local kernels = {}
+
+local function gen_kernel(e)
+   local ctx = {scalars = {}, matrices = {}, index = {}}
+   local term = gen_term(e, ctx)
+   local params = {'n1', 'n2', 'c', 'tc'}
+   for k = 1, #ctx.matrices do
+      params[#params+1] = 'd' .. k
+      params[#params+1] = 't' .. k
+   end
+   for k = 1, #ctx.scalars do params[#params+1] = 's' .. k end
+
+   local src = format([[
+return function(%s)
+   for i = 0, n1-1 do
+      for j = 0, n2-1 do
+         c[i*tc+j] = %s
+      end
+   end
+end]], concat(params, ', '), term)
+
+   local kernel = kernels[src]
+   if not kernel then
+      kernel = assert(loadstring(src, 'matrix expression'))()
+      kernels[src] = kernel
+   end
+   return kernel, ctx
+end
+
+local function expr_eval(e, dest)
+   local n1, n2 = e.n1, e.n2
+   if dest and (tonumber(dest.size1) ~= n1 or tonumber(dest.size2) ~= n2) then
+      error('matrix dimensions does not match', 2)
+   end
+
+   if not is_real_expr(e) then
+      local r = interp(e)
+      if not dest then return e.m and r:copy() or r end
+      matrix.set(dest, r)
+      return dest
+   end
+
+   local c = dest or matrix.alloc(n1, n2)
+   local kernel, ctx = gen_kernel(e)
+   local args = {n1, n2, c.data, tonumber(c.tda)}
+   for k, m in ipairs(ctx.matrices) do
+      args[#args+1] = m.data
+      args[#args+1] = tonumber(m.tda)
+   end
+   for k, s in ipairs(ctx.scalars) do args[#args+1] = s end
+   kernel(unpack(args))
+   return c
+end
+
+local function expr_barrier(x)
+   return is_expr(x) and expr_eval(x) or x
+end
+
+local function check_dims(a, b)
+   if is_expr(a) and is_expr(b) and (a.n1 ~= b.n1 or a.n2 ~= b.n2) then
+      error('matrix dimensions does not match', 3)
+   end
+end
+
+expr_mt.__add = function(a, b)
+   a, b = operand(a), operand(b)
+   check_dims(a, b)
+   return expr_op('+', a, b)
+end
+
+expr_mt.__sub = function(a, b)
+   a, b = operand(a), operand(b)
+   check_dims(a, b)
+   return expr_op('-', a, b)
+end
+
+expr_mt.__mul = function(a, b)
+   a, b = operand(a), operand(b)
+   if is_expr(a) and is_expr(b) then
+      return expr_leaf(expr_barrier(a) * expr_barrier(b))
+   end
+   return expr_op('*', a, b)
+end
+
+expr_mt.__div = function(a, b)
+   a, b = operand(a), operand(b)
+   if is_expr(b) then error('invalid operation on matrix', 2) end
+   return expr_op('/', a, b)
+end
+
+expr_mt.__unm = function(a)
+   return expr_op('neg', a)
+end
+
+expr_mt.__pow = function(a, n)
+   return expr_leaf(expr_barrier(a) ^ n)
+end
+
+expr_mt.__index = {eval = expr_eval}
+
+local function matrix_lazy(m)
+   if not is_matrix(m) then error('expecting a matrix', 2) end
+   return expr_leaf(m)
+end
+
+local function matrix_expr(f, ...)
+   local n = select('#', ...)
+   local args = {...}
+   for k = 1, n do
+      if is_matrix(args[k]) then args[k] = expr_leaf(args[k]) end
+   end
+   local e = f(unpack(args, 1, n))
+   return is_expr(e) and expr_eval(e) or e
+end
+
+return {lazy = matrix_lazy, expr = matrix_expr}
@@ -0,0 +1,107 @@
+local ffi = require 'ffi'
+
+-- the gsl_block type is defined by the gsl module
+require 'gsl'
+
+-- Pooled allocator for the gsl_block used by matrices. The block
+-- header and its data are obtained with a single malloc. The data is
+-- stored after the header with the requested alignment. When a block
+-- is released it is put in a free list indexed by its capacity so
+-- that it can be immediately reused by the next allocation of a
+-- similar size. The total memory retained in the free lists is
+-- bounded by a configurable limit. Each block records the alignment
+-- used for its data so that the blocks allocated before a change of
+-- the alignment are not put back in the free lists.
+
+ffi.cdef [[
+   typedef struct {
+      gsl_block block;
+      size_t capacity;
+      size_t align;
+   } pool_block;
+]]
+
+local pool_block_ptr = ffi.typeof('pool_block *')
+local gsl_block_ptr  = ffi.typeof('gsl_block *')
+local uintptr_t      = ffi.typeof('uintptr_t')
+
+local header_size = ffi.sizeof('pool_block')
+local line_size = 64
+
+local align = 16
+local limit = 64 * 1024 * 1024
+
+local free_lists = {}
+local pooled = 0
+
+local function pool_flush()
+   for capacity, list in pairs(free_lists) do
+      for k = 1, #list do ffi.C.free(list[k]) end
+   end
+   free_lists = {}
+   pooled = 0
+end
+
+local function new_block(capacity)
+   local p = ffi.C.malloc(header_size + align + capacity)
+   if p == nil then error('not enough memory', 3) end
+   local pb = ffi.cast(pool_block_ptr, p)
+   local addr = ffi.cast(uintptr_t, p) + header_size
+   addr = addr + (align - addr % align) % align
+   pb.capacity = capacity
+   pb.align = align
+   pb.block.data = ffi.cast('double *', addr)
+   return pb
+end
+
+-- return a block of "n" elements whose data is "nbytes" long
+local function pool_alloc(n, nbytes)
+   local capacity = math.ceil(nbytes / line_size) * line_size
+   local list = free_lists[capacity]
+   local pb
+   if list and #list > 0 then
+      pb = list[#list]
+      list[#list] = nil
+      pooled = pooled - capacity
+   else
+      pb = new_block(capacity)
+   end
+   local b = ffi.cast(gsl_block_ptr, pb)
+   b.size, b.ref_count = n, 1
+   return b
+end
+
+local function pool_release(b)
+   local pb = ffi.cast(pool_block_ptr, b)
+   local capacity = tonumber(pb.capacity)
+   if pb.align == align and pooled + capacity <= limit then
+      local list = free_lists[capacity]
+      if not list then
+         list = {}
+         free_lists[capacity] = list
+      end
+      list[#list+1] = pb
+      pooled = pooled + capacity
+   else
+      ffi.C.free(pb)
+   end
+end
+
+local function pool_setup(options)
+   if options.limit then
+      limit = options.limit
+      if pooled > limit then pool_flush() end
+   end
+   if options.align and options.align ~= align then
+      local a = options.align
+      if a < 8 or a % 8 ~= 0 then
+         error('alignment should be a multiple of 8', 2)
+      end
+      -- the blocks in the free lists have the previous alignment
+      pool_flush()
+      align = a
+   end
+   return {limit = limit, align = align, pooled = pooled}
+end
+
+return {alloc = pool_alloc, release = pool_release, setup = pool_setup}
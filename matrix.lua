@@ -13,6 +13,7 @@ local gsl_matrix_complex = ffi.typeof('gsl_matrix_complex')
 local gsl_complex        = ffi.typeof('complex')
 
 local gsl_check = require 'gsl-check'
+local blas = require 'blas'
 local tonumber = tonumber
 
 local function check_real(x)
@@ -49,29 +50,52 @@ local function matrix_len(m)
    return tonumber(m.size1)
 end
 
+local pool = require 'matrix-pool'
+
+local double_size = ffi.sizeof('double')
+
+-- list of the temporary matrices created by the arithmetic operators
+-- in the innermost matrix.scope
+local scope_list
+
 local function block_alloc(n)
-   local b = ffi.cast('gsl_block *', ffi.C.malloc(ffi.sizeof('gsl_block')))
-   local data = ffi.C.malloc(n * ffi.sizeof('double'))
-   b.size, b.data, b.ref_count = n, data, 1
-   return b
+   return pool.alloc(n, n * double_size)
 end
 
 local function block_calloc(n)
-   local b = ffi.cast('gsl_block_complex *', ffi.C.malloc(ffi.sizeof('gsl_block_complex')))
-   local data = ffi.C.malloc(2 * n * ffi.sizeof('double'))
-   b.size, b.data, b.ref_count = n, data, 1
-   return b
+   return pool.alloc(n, 2 * n * double_size)
+end
+
+local function block_release(b)
+   b.ref_count = b.ref_count - 1
+   if b.ref_count == 0 then
+      pool.release(b)
+   end
 end
 
 local function matrix_alloc(n1, n2)
    local b = block_alloc(n1 * n2)
-   local m = gsl_matrix(n1, n2, n2, b.data, b, 1)
-   return m
+   return gsl_matrix(n1, n2, n2, b.data, b, 1)
 end
 
 local function matrix_calloc(n1, n2)
    local b = block_calloc(n1 * n2)
-   local m = gsl_matrix_complex(n1, n2, n2, b.data, b, 1)
+   return gsl_matrix_complex(n1, n2, n2, b.data, b, 1)
+end
+
+-- The results of the arithmetic operators are the only matrices
+-- released by matrix.scope. The matrices created explicitly, like
+-- with matrix.alloc, can be kept by the modules and are left to the
+-- garbage collector.
+local function temp_alloc(n1, n2)
+   local m = matrix_alloc(n1, n2)
+   if scope_list then scope_list[#scope_list+1] = m end
+   return m
+end
+
+local function temp_calloc(n1, n2)
+   local m = matrix_calloc(n1, n2)
+   if scope_list then scope_list[#scope_list+1] = m end
    return m
 end
 
@@ -116,14 +140,53 @@ local function matrix_cnew(n1, n2, f)
 end
 
 local function matrix_free(m)
-   if m.owner then
-      local b = m.block
-      b.ref_count = b.ref_count - 1
-      if b.ref_count == 0 then
-         ffi.C.free(b.data)
-         ffi.C.free(b)
+   if m.owner == 1 then
+      block_release(m.block)
+   end
+end
+
+-- mark the matrices reachable from x, looking inside the tables
+local function scope_mark(x, keep)
+   local tp = type(x)
+   if tp == 'cdata' then
+      keep[x] = true
+   elseif tp == 'table' and not keep[x] then
+      keep[x] = true
+      for k, v in pairs(x) do
+         scope_mark(k, keep)
+         scope_mark(v, keep)
+      end
+      local mt = getmetatable(x)
+      if type(mt) == 'table' then scope_mark(mt, keep) end
+   end
+end
+
+local function scope_leave(list, parent, ok, ...)
+   scope_list = parent
+   local keep = {}
+   if ok then
+      for k = 1, select('#', ...) do scope_mark((select(k, ...)), keep) end
+   end
+   for k = 1, #list do
+      local m = list[k]
+      if keep[m] then
+         if parent then parent[#parent+1] = m end
+      elseif m.owner == 1 then
+         -- the matrix is invalidated so that the finalizer does not
+         -- release its block a second time
+         matrix_free(m)
+         m.size1, m.size2, m.data, m.block, m.owner = 0, 0, nil, nil, 0
       end
    end
+   if not ok then error((...), 0) end
+   return ...
+end
+
+local function matrix_scope(f, ...)
+   local parent = scope_list
+   local list = {}
+   scope_list = list
+   return scope_leave(list, parent, pcall(f, ...))
 end
 
 local function matrix_copy(a)
@@ -390,7 +453,7 @@ local function matrix_vect_def(t)
 end
 
 local function mat_op_gen(n1, n2, opa, a, opb, b, oper)
-   local c = matrix_alloc(n1, n2)
+   local c = temp_alloc(n1, n2)
    for i = 0, n1-1 do
       for j = 0, n2-1 do
          local ar = opa(a,i,j)
@@ -402,7 +465,7 @@ local function mat_op_gen(n1, n2, opa, a, opb, b, oper)
 end
 
 local function mat_comp_op_gen(n1, n2, opa, a, opb, b, oper)
-   local c = matrix_calloc(n1, n2)
+   local c = temp_calloc(n1, n2)
    for i = 0, n1-1 do
       for j = 0, n2-1 do
          local ar, ai = opa(a,i,j)
@@ -434,7 +497,7 @@ end
 
 local function mat_complex_of_real(m)
    local n1, n2 = matrix_dim(m)
-   local mc = matrix_calloc(n1, n2)
+   local mc = temp_calloc(n1, n2)
    for i=0, n1-1 do
       for j=0, n2-1 do
          mc.data[2*i*n2+2*j  ] = m.data[i*n2+j]
@@ -465,8 +528,15 @@ local function opdiv(ar, br, ai, bi)
    end
 end
 
-local function vector_op(scalar_op, element_wise, no_inverse)
+-- When one of the operands is a table, like a deferred expression of
+-- matrix.lazy, the operation is delegated to its metamethod "event".
+local function vector_op(scalar_op, event, element_wise, no_inverse)
    return function(a, b)
+             if type(a) == 'table' or type(b) == 'table' then
+                local mt = getmetatable(type(b) == 'table' and b or a)
+                local mm = mt and mt[event]
+                if mm then return mm(a, b) end
+             end
              local ra, sa = get_typeid(a)
              local rb, sb = get_typeid(b)
              if not sb and no_inverse then
@@ -489,17 +559,15 @@ local function vector_op(scalar_op, element_wise, no_inverse)
              else
                 if ra and rb then
                    local n1, n2 = tonumber(a.size1), tonumber(b.size2)
-                   local c = matrix_alloc(n1, n2)
-                   local NT = gsl.CblasNoTrans
-                   gsl_check(gsl.gsl_blas_dgemm(NT, NT, 1, a, b, 0, c))
+                   local c = temp_alloc(n1, n2)
+                   blas.dgemm(a, b, c)
                    return c
                 else
                    if ra then a = mat_complex_of_real(a) end
                    if rb then b = mat_complex_of_real(b) end
                    local n1, n2 = tonumber(a.size1), tonumber(b.size2)
-                   local c = matrix_calloc(n1, n2)
-                   local NT = gsl.CblasNoTrans
-                   gsl_check(gsl.gsl_blas_zgemm(NT, NT, 1, a, b, 0, c))
+                   local c = temp_calloc(n1, n2)
+                   blas.zgemm(a, b, c)
                    return c
                 end
              end
@@ -513,7 +581,7 @@ end
 
 local function matrix_unm(a)
    local n1, n2 = matrix_dim(a)
-   local m = matrix_alloc(n1, n2)
+   local m = temp_alloc(n1, n2)
    for i=0, n1-1 do
       for j=0, n2-1 do
          m.data[n2*i+j] = -a.data[n2*i+j]
@@ -524,7 +592,7 @@ end
 
 local function matrix_complex_unm(a)
    local n1, n2 = matrix_dim(a)
-   local m = matrix_calloc(n1, n2)
+   local m = temp_calloc(n1, n2)
    for i=0, n1-1 do
       for j=0, n2-1 do
          m.data[2*n2*i+2*j  ] = -a.data[2*n2*i+2*j  ]
@@ -583,10 +651,10 @@ complex = {
    arg   = complex_arg
 }
 
-local generic_add = vector_op(opadd, true)
-local generic_sub = vector_op(opsub, true)
-local generic_mul = vector_op(opmul, false)
-local generic_div = vector_op(opdiv, true, true)
+local generic_add = vector_op(opadd, '__add', true)
+local generic_sub = vector_op(opsub, '__sub', true)
+local generic_mul = vector_op(opmul, '__mul', false)
+local generic_div = vector_op(opdiv, '__div', true, true)
 
 local complex_mt = {
 
@@ -687,9 +755,16 @@ matrix = {
    set    = matrix_set_equal,
    fset   = matrix_fset,
    block  = block_alloc,
+   scope  = matrix_scope,
+   pool   = pool.setup,
+
+   block_release = block_release,
 
    transpose = matrix_new_transpose,
    hc        = matrix_new_hc,
+
+   set_blas  = blas.select,
+   blas      = blas.name,
 }
 
 local function matrix_sort(m, f)
@@ -1180,6 +1255,11 @@ matrix.tr = function(a)
 matrix.def  = matrix_def
 matrix.cdef = matrix_cdef
 
+local matrix_expr = require 'matrix-expr'
+
+matrix.lazy = matrix_expr.lazy
+matrix.expr = matrix_expr.expr
+
 local register_ffi_type = debug.getregistry().__gsl_reg_ffi_type
 
 register_ffi_type(gsl_complex, "complex")
@@ -0,0 +1,133 @@
+-- parallel-worker.lua
+--
+-- Code executed in the worker states of the parallel module. Each task
+-- computes a range of the elements of a matrix shared with the main
+-- state through the address of its data. The same kernels are used by
+-- the main state when no worker is available.
+--
+-- Copyright (C) 2013 Francesco Abbate
+--
+
+local ffi = require 'ffi'
+
+local floor = math.floor
+
+-- range of elements [lo, hi) of the k-th task out of nt
+local function task_range(k, nt, n)
+   return floor((k - 1) * n / nt), floor(k * n / nt)
+end
+
+local function data_pointer(addr)
+   return ffi.cast('double *', ffi.cast('uintptr_t', addr))
+end
+
+local kernels = {}
+
+function kernels.map(f, k, nt, src, dst, n1, n2, stda, dtda)
+   local s, d = data_pointer(src), data_pointer(dst)
+   local lo, hi = task_range(k, nt, n1 * n2)
+   for e = lo, hi - 1 do
+      local i = floor(e / n2)
+      local j = e - i * n2
+      d[i * dtda + j] = f(s[i * stda + j])
+   end
+end
+
+function kernels.fill(f, k, nt, dst, n1, n2, tda)
+   local d = data_pointer(dst)
+   local lo, hi = task_range(k, nt, n1 * n2)
+   for e = lo, hi - 1 do
+      local i = floor(e / n2)
+      local j = e - i * n2
+      d[i * tda + j] = f(i + 1, j + 1)
+   end
+end
+
+function kernels.sample(f, k, nt, dst, tda, n, xi, xs)
+   local d = data_pointer(dst)
+   local c = (xs - xi) / n
+   local lo, hi = task_range(k, nt, n + 1)
+   for i = lo, hi - 1 do
+      local x = xi + i * c
+      d[i * tda], d[i * tda + 1] = x, f(x)
+   end
+end
+
+function kernels.reduce(f, k, nt, src, n1, n2, tda, init)
+   local s = data_pointer(src)
+   local lo, hi = task_range(k, nt, n1 * n2)
+   local acc = init
+   for e = lo, hi - 1 do
+      local i = floor(e / n2)
+      local j = e - i * n2
+      acc = f(acc, s[i * tda + j])
+   end
+   return acc
+end
+
+-- refine with the Brent method the nb brackets stored at "src" as
+-- xa, fa, xb, fb and the tolerance on f and write the roots at "dst"
+function kernels.brent(f, k, nt, src, dst, nb, del)
+   local brent = require('roots').brent
+   local b, r = data_pointer(src), data_pointer(dst)
+   local lo, hi = task_range(k, nt, nb)
+   for i = lo, hi - 1 do
+      local p = b + 5 * i
+      r[i] = brent(f, p[0], p[1], p[2], p[3], p[4], del)
+   end
+end
+
+-- The modules that do not need the graphics are loaded on demand when
+-- one of their global variables is accessed, like in the main state.
+local autoload = {
+   matrix  = {'matrix'},
+   complex = {'matrix'},
+   sf      = {'sf'},
+   rng     = {'rng'},
+   rnd     = {'rnd'},
+   randist = {'randist'},
+   eigen   = {'eigen'},
+   num     = {'num', 'integ-init', 'fft-init', 'vegas', 'linfit'},
+}
+
+local function init_worker()
+   require 'iter'
+   setmetatable(_G, {__index = function(t, name)
+                                  local modules = autoload[name]
+                                  if modules then
+                                     autoload[name] = nil
+                                     for _, modname in ipairs(modules) do require(modname) end
+                                     return rawget(t, name)
+                                  end
+                               end})
+end
+
+-- the functions are loaded once for each code and their upvalues are
+-- set at each task
+local functions = {}
+
+local function load_function(code, nups, ...)
+   local f = functions[code]
+   if not f then
+      f = assert(loadstring(code))
+      functions[code] = f
+   end
+   for i = 1, nups do
+      debug.setupvalue(f, i, (select(i, ...)))
+   end
+   return f
+end
+
+-- called by the C code for each task with the task index, the number
+-- of tasks, the kernel name, the function's bytecode and upvalues and
+-- the kernel's arguments
+local function task(k, nt, kind, code, nups, ...)
+   local f = load_function(code, nups, ...)
+   return kernels[kind](f, k, nt, select(nups + 1, ...))
+end
+
+if debug.getregistry().__gsl_parallel_worker then
+   init_worker()
+end
+
+return {task= task, kernels= kernels}
@@ -0,0 +1,144 @@
+-- parallel.lua
+--
+-- Parallel evaluation of functions over the elements of a matrix. The
+-- elements are divided in tasks that are executed by a pool of worker
+-- threads, each one with its own Lua state. The functions are sent to
+-- the workers as bytecode and can only have numbers, strings or
+-- booleans as upvalues. The other variables should be accessed as
+-- globals, like "math.sin" or "sf.besselJ". The data of the matrices
+-- is shared with the workers without copies.
+--
+-- Copyright (C) 2013 Francesco Abbate
+--
+
+local ffi = require 'ffi'
+local worker = require 'parallel-worker'
+
+local pool = debug.getregistry().__gsl_parallel
+local kernels = worker.kernels
+local format = string.format
+
+-- number of tasks for each worker to balance the load when the cost of
+-- the function is not uniform
+local tasks_per_worker = 4
+
+parallel = {}
+
+-- return the number of workers, starting the pool if needed. Zero is
+-- returned if the pool is not available, like inside a worker.
+local function workers_count()
+   if not pool or debug.getregistry().__gsl_parallel_worker then return 0 end
+   local n = pool.workers()
+   if n == 0 then n = pool.start() end
+   return n
+end
+
+function parallel.workers(n)
+   if n and pool and pool.workers() == 0 then return pool.start(n) end
+   return workers_count()
+end
+
+local function dump_function(f)
+   if type(f) ~= 'function' then error('expecting a function', 4) end
+   local ok, code = pcall(string.dump, f)
+   if not ok then error('only Lua functions can be evaluated in parallel', 4) end
+   local ups = {}
+   local nups = 0
+   while true do
+      local name, v = debug.getupvalue(f, nups + 1)
+      if not name then break end
+      local tp = type(v)
+      if tp ~= 'number' and tp ~= 'string' and tp ~= 'boolean' and tp ~= 'nil' then
+         error(format("the upvalue '%s' of type %s cannot be sent to the workers", name, tp), 4)
+      end
+      nups = nups + 1
+      ups[nups] = v
+   end
+   return code, nups, ups
+end
+
+local function address(m)
+   return tonumber(ffi.cast('uintptr_t', m.data))
+end
+
+local function pointer_address(p)
+   return tonumber(ffi.cast('uintptr_t', p))
+end
+
+local function check_matrix(m)
+   if not ffi.istype('gsl_matrix', m) then error('expecting a real matrix', 3) end
+end
+
+-- run the kernel "kind" over n elements with the given arguments and
+-- return the table of the results of each task
+local function run(kind, f, n, ...)
+   local nw = workers_count()
+   if nw == 0 or n < 2 then
+      return {kernels[kind](f, 1, 1, ...)}
+   end
+   local code, nups, ups = dump_function(f)
+   local args = {kind, code, nups}
+   for i = 1, nups do args[3 + i] = ups[i] end
+   local nargs = 3 + nups + select('#', ...)
+   for i = 1, select('#', ...) do args[3 + nups + i] = (select(i, ...)) end
+   local ntasks = math.min(n, nw * tasks_per_worker)
+   return pool.run(ntasks, unpack(args, 1, nargs))
+end
+
+-- return a new matrix with the values of f for each element of m
+function parallel.map(f, m)
+   check_matrix(m)
+   local n1, n2 = tonumber(m.size1), tonumber(m.size2)
+   local r = matrix.alloc(n1, n2)
+   run('map', f, n1 * n2, address(m), address(r), n1, n2, tonumber(m.tda), tonumber(r.tda))
+   return r
+end
+
+-- set each element of m to f(i, j) like matrix.fset
+function parallel.fill(m, f)
+   check_matrix(m)
+   local n1, n2 = tonumber(m.size1), tonumber(m.size2)
+   run('fill', f, n1 * n2, address(m), n1, n2, tonumber(m.tda))
+   return m
+end
+
+-- return two column matrices with the n+1 points x from xi to xs, like
+-- iter.sample, and the values f(x)
+function parallel.sample(f, xi, xs, n)
+   local r = matrix.alloc(n + 1, 2)
+   run('sample', f, n + 1, address(r), tonumber(r.tda), n, xi, xs)
+   return r:col(1), r:col(2)
+end
+
+-- Accumulate the elements of m with acc = f(acc, x) starting from
+-- init. Each task accumulates a part of the elements starting from
+-- init, so it should be the identity of the operation, and the partial
+-- results are combined with the function "combine", by default f
+-- itself.
+function parallel.reduce(f, m, init, combine)
+   check_matrix(m)
+   if type(init) ~= 'number' then error('expecting a number as initial value', 2) end
+   local n1, n2 = tonumber(m.size1), tonumber(m.size2)
+   local partial = run('reduce', f, n1 * n2, address(m), n1, n2, tonumber(m.tda), init)
+   combine = combine or f
+   local acc = init
+   for k = 1, table.maxn(partial) do
+      if partial[k] then acc = combine(acc, partial[k]) end
+   end
+   return acc
+end
+
+-- Refine with the Brent method the nb brackets stored in the double
+-- array "brackets" as xa, fa, xb, fb and the tolerance on f, and
+-- write the roots in the array "roots". It is used by the roots
+-- solver. If f cannot be sent to the workers or fails in them, for
+-- example because it uses a global variable defined only in the main
+-- state, the brackets are refined again in sequence.
+function parallel.brent(f, brackets, roots, nb, del)
+   local src, dst = pointer_address(brackets), pointer_address(roots)
+   if not pcall(run, 'brent', f, nb, src, dst, nb, del) then
+      kernels.brent(f, 1, 1, src, dst, nb, del)
+   end
+end
+
+return parallel
@@ -1,7 +1,4 @@
 
-local Pre3d = require 'pre3d/pre3d'
-local ShapeUtils = require 'pre3d/pre3d_shape_utils'
-
 local pi = math.pi
 local rgb = graph.rgb
 
@@ -12,33 +9,34 @@ local function opt_gener(options, defaults)
 	  end
 end
 
-local function set_transform(ct, rx, ry, dz)
-   ct:reset()
-   ct:rotateZ(0)
-   ct:rotateX(rx)
-   ct:rotateY(ry)
-   ct:translate(0, 0, dz and -dz or -80)
+-- the surfaces are drawn by a native mesh object that projects, sorts
+-- and shades the faces. The mesh is seen by a camera that looks down
+-- the negative z axis.
+local camera = {rx= -pi/2 + pi/16, ry= -pi/16, distance= 80, focal= 30}
+
+-- faces of a grid of (nu+1) x (nv+1) vertices stored by rows
+local function grid_faces(nu, nv)
+   local f = matrix.alloc(nu * nv, 4)
+   local d = f.data
+   local k = 0
+   for i = 0, nu - 1 do
+      for j = 0, nv - 1 do
+	 local i0 = i * (nv + 1) + j + 1
+	 d[4*k], d[4*k+1], d[4*k+2], d[4*k+3] = i0, i0 + nv + 1, i0 + nv + 2, i0 + 1
+	 k = k + 1
+      end
+   end
+   return f
 end
 
-local function render_shape(shape, plt, stroke)
-   local renderer = Pre3d.Renderer(plt)
-
-   renderer.draw_overdraw = true 
-   renderer.draw_backfaces = true
-   renderer.fill_rgba = rgb(0x4A, 0x92, 0xBF)
-   renderer.fill_rgba_backside = rgb(0xBF, 0x92, 0x4A)
-   if stroke then renderer.stroke_rgba = rgb(50, 50, 50) end
-   renderer.set_light_intensity = true
-
-   renderer.camera.focal_length = 30;
-
-   set_transform(renderer.camera.transform, -pi/2 + pi/16, -pi/16)
-
-   renderer:bufferShape(shape)
-   renderer:drawBuffer()
-   renderer:emptyBuffer()
-   
-   return renderer
+local function render_mesh(plt, vertices, faces, stroke)
+   local mesh = graph.mesh3d(vertices, faces,
+			     {color= rgb(0x4A, 0x92, 0xBF),
+			      backcolor= rgb(0xBF, 0x92, 0x4A),
+			      stroke= stroke and rgb(50, 50, 50) or nil})
+   mesh:camera(camera.rx, camera.ry, camera.distance, camera.focal)
+   plt:add(mesh, 'black')
+   return mesh
 end
 
 function graph.plot3d(f, x1, y1, x2, y2, options)
@@ -48,12 +46,32 @@ function graph.plot3d(f, x1, y1, x2, y2, options)
    local nx = opt 'gridx'
    local ny = opt 'gridy'
 
-   local shape = ShapeUtils.makeXYFunction(f, x1, y1, x2, y2, nx, ny)
-
-   render_shape(shape, plt, opt 'stroke')
+   local v = matrix.alloc((nx + 1) * (ny + 1), 3)
+   local d = v.data
+   local zmin, zmax
+   for i = 0, nx do
+      local x = x1 + (x2 - x1) * i / nx
+      for j = 0, ny do
+	 local y = y1 + (y2 - y1) * j / ny
+	 local z = f(x, y)
+	 if not zmin or z < zmin then zmin = z end
+	 if not zmax or z > zmax then zmax = z end
+	 local k = i * (ny + 1) + j
+	 d[3*k], d[3*k+1], d[3*k+2] = i / nx - 0.5, j / ny - 0.5, z
+      end
+   end
+
+   -- the surface is scaled to fit in a unit box centered at the origin
+   -- with an height of one half
+   local zscale = (zmax > zmin and 2 * (zmax - zmin) or 1)
+   for k = 0, (nx + 1) * (ny + 1) - 1 do
+      d[3*k+2] = (d[3*k+2] - zmin) / zscale - 0.25
+   end
+
+   local mesh = render_mesh(plt, v, grid_faces(nx, ny), opt 'stroke')
 
    plt:show()
-   return plt
+   return plt, mesh
 end
 
 function graph.surfplot(fs, u1, v1, u2, v2, options)
@@ -64,10 +82,19 @@ function graph.surfplot(fs, u1, v1, u2, v2, options)
    local nv = opt 'gridv'
 
    local x, y, z = fs[1], fs[2], fs[3]
-   local shape = ShapeUtils.makeUVSurface(x, y, z, u1, v1, u2, v2, nu, nv)
-
-   render_shape(shape, plt, opt 'stroke')
+   local m = matrix.alloc((nu + 1) * (nv + 1), 3)
+   local d = m.data
+   for i = 0, nu do
+      local u = u1 + (u2 - u1) * i / nu
+      for j = 0, nv do
+	 local v = v1 + (v2 - v1) * j / nv
+	 local k = i * (nv + 1) + j
+	 d[3*k], d[3*k+1], d[3*k+2] = x(u, v), y(u, v), z(u, v)
+      end
+   end
+
+   local mesh = render_mesh(plt, m, grid_faces(nu, nv), opt 'stroke')
 
    plt:show()
-   return plt
+   return plt, mesh
 end
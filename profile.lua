@@ -0,0 +1,134 @@
+-- profile.lua
+--
+-- Interface to the sampling profiler. The samples are collected by the
+-- C code as "collapsed stacks": a string with the frames from the
+-- outermost to the innermost separated by semicolons.
+--
+-- Copyright (C) 2013 Francesco Abbate
+--
+
+local prof = debug.getregistry().__gsl_profiler
+
+local format, concat = string.format, table.concat
+
+profile = {}
+
+local interval
+
+function profile.start(options)
+   interval = options and options.interval or 1
+   prof.start(math.floor(interval * 1000))
+end
+
+function profile.stop()
+   prof.stop()
+end
+
+local function split_stack(stack)
+   local frames = {}
+   for frame in stack:gmatch('[^;]+') do frames[#frames+1] = frame end
+   return frames
+end
+
+local function sorted_keys(t, count)
+   local keys = {}
+   for k in pairs(t) do keys[#keys+1] = k end
+   table.sort(keys, function(a, b) return count(a) > count(b) end)
+   return keys
+end
+
+local function build_tree(samples)
+   local root = {count = 0, children = {}}
+   for stack, n in pairs(samples) do
+      local node = root
+      root.count = root.count + n
+      for _, frame in ipairs(split_stack(stack)) do
+         local child = node.children[frame]
+         if not child then
+            child = {count = 0, children = {}}
+            node.children[frame] = child
+         end
+         child.count = child.count + n
+         node = child
+      end
+   end
+   return root
+end
+
+local function report_flat(samples, total, threshold)
+   local self_count, total_count = {}, {}
+   for stack, n in pairs(samples) do
+      local frames = split_stack(stack)
+      local leaf = frames[#frames]
+      self_count[leaf] = (self_count[leaf] or 0) + n
+      -- recursive functions are counted only once
+      local seen = {}
+      for _, frame in ipairs(frames) do
+         if not seen[frame] then
+            total_count[frame] = (total_count[frame] or 0) + n
+            seen[frame] = true
+         end
+      end
+   end
+   print(format('%7s %7s  %s', 'self', 'total', 'function'))
+   local keys = sorted_keys(total_count, |k| self_count[k] or 0)
+   for _, frame in ipairs(keys) do
+      local s, t = self_count[frame] or 0, total_count[frame]
+      if 100 * t / total >= threshold then
+         print(format('%6.1f%% %6.1f%%  %s', 100 * s / total, 100 * t / total, frame))
+      end
+   end
+end
+
+local function report_tree(node, total, threshold, indent)
+   local keys = sorted_keys(node.children, |k| node.children[k].count)
+   for _, frame in ipairs(keys) do
+      local child = node.children[frame]
+      if 100 * child.count / total >= threshold then
+         print(format('%6.1f%% %s%s', 100 * child.count / total, indent, frame))
+         report_tree(child, total, threshold, indent .. '  ')
+      end
+   end
+end
+
+local function write_collapsed(samples, filename)
+   local f = assert(io.open(filename, 'w'))
+   for stack, n in pairs(samples) do
+      f:write(stack, ' ', n, '\n')
+   end
+   f:close()
+end
+
+function profile.report(options)
+   options = options or {}
+   local samples = prof.samples()
+   if not samples then error('the profiler was never started', 2) end
+   local threshold = options.threshold or 1
+   local mode = options.mode or 'flat'
+
+   local total = 0
+   for _, n in pairs(samples) do total = total + n end
+
+   print(format('%i samples every %g ms', total, interval))
+   if total > 0 then
+      if mode == 'flat' then
+         report_flat(samples, total, threshold)
+      elseif mode == 'tree' then
+         report_tree(build_tree(samples), total, threshold, '')
+      else
+         error('unknown report mode: ' .. mode, 2)
+      end
+   end
+
+   local others = {}
+   for zone, n in pairs(prof.zones()) do
+      if n > 0 then others[#others+1] = format('%s %i', zone, n) end
+   end
+   if #others > 0 then
+      print('samples in other threads: ' .. concat(others, ', '))
+   end
+
+   if options.collapsed then write_collapsed(samples, options.collapsed) end
+end
+
+return profile
@@ -1,8 +1,10 @@
 
 local gsl = require 'gsl'
 local ffi = require 'ffi'
+local bit = require 'bit'
 
 local format, tonumber = string.format, tonumber
+local bxor, rshift = bit.bxor, bit.rshift
 
 local M = {}
 
@@ -12,6 +14,22 @@ local function rng_getint(r, seed)
    return tonumber(gsl.gsl_rng_uniform_int(r, seed))
 end
 
+local gsl_matrix = ffi.typeof('gsl_matrix')
+
+local function rng_fill(r, m)
+   if not ffi.istype(gsl_matrix, m) then
+      error('bad argument #2 to fill (real matrix expected)', 2)
+   end
+   local n1, n2, tda = tonumber(m.size1), tonumber(m.size2), tonumber(m.tda)
+   local data, uniform = m.data, gsl.gsl_rng_uniform
+   for i = 0, n1-1 do
+      for j = 0, n2-1 do
+         data[i*tda+j] = uniform(r)
+      end
+   end
+   return m
+end
+
 local rng_mt = {
    __tostring = function(s)
                    return format("<random number generator: %p>", s)
@@ -21,6 +39,7 @@ local rng_mt = {
       getint = rng_getint,
       get    = gsl.gsl_rng_uniform,
       set    = gsl.gsl_rng_set,
+      fill   = rng_fill,
    },
 }
 
@@ -47,6 +66,31 @@ function M.new(s)
    return ffi.gc(gsl.gsl_rng_alloc(T), gsl.gsl_rng_free)
 end
 
+-- multiplication modulo 2^32 without loss of precision
+local function mul32(a, b)
+   local ah, al = rshift(a, 16), a % 65536
+   return ((ah * b) % 65536 * 65536 + al * b) % 2^32
+end
+
+-- finalization step of MurmurHash3, used to obtain well separated seeds
+-- for consecutive stream indexes
+local function fmix32(h)
+   h = bxor(h, rshift(h, 16)) % 2^32
+   h = mul32(h, 0x85ebca6b)
+   h = bxor(h, rshift(h, 13)) % 2^32
+   h = mul32(h, 0xc2b2ae35)
+   return bxor(h, rshift(h, 16)) % 2^32
+end
+
+function M.stream(seed, index, s)
+   local T = rng_type_lookup(s)
+   local r = ffi.gc(gsl.gsl_rng_alloc(T), gsl.gsl_rng_free)
+   local h = fmix32(seed % 2^32)
+   h = fmix32(bxor(h, mul32(index % 2^32, 0x9e3779b9)) % 2^32)
+   gsl.gsl_rng_set(r, h)
+   return r
+end
+
 function M.list()
    local t = {}
    local ts = gsl.gsl_rng_types_setup()
@@ -1,5 +1,7 @@
 
-local abs, max, min = math.abs, math.max, math.min
+local ffi = require 'ffi'
+
+local abs, max, min, floor = math.abs, math.max, math.min, math.floor
 
 local function is_between(x, a, b)
    if b < a then a, b = b, a end
@@ -143,6 +145,12 @@ local function solver_tolerance(s, eps, del)
    s.del = del
 end
 
+-- enable the refinement of the roots by the workers of the parallel
+-- module in solve_grid
+local function solver_parallel(s, on)
+   s.use_parallel = on
+end
+
 local function solver_root(s, x0, x1)
    local f = s.f
    return brent(f, x0, f(x0), x1, f(x1), s.eps, s.del)
@@ -157,13 +165,88 @@ local function solver_interval_solve(s, x0, x1, roots)
    return s.roots
 end
 
+-- Sample the function on a uniform grid of n intervals and refine each
+-- interval where the function changes sign. The function values on the
+-- grid can be computed in bulk by the optional function f_many(xs, ys,
+-- n) that should set ys[i] = f(xs[i]) for i = 0, n-1. If enabled with
+-- solver:parallel(true) the brackets of the sign changes are refined
+-- concurrently by the workers of the parallel module, otherwise they
+-- are refined in sequence. Around a local minimum of |f| without a
+-- sign change the grid could miss a pair of close roots so the
+-- adaptive subdivision is used there.
+local function solver_grid_solve(s, x0, x1, n, f_many, roots)
+   if type(n) ~= 'number' or n < 1 or n ~= floor(n) then
+      error('the number of intervals should be an integer >= 1', 2)
+   end
+   local f = s.f
+   s.roots = roots or {}
+   s.rng = s.rng or rng.new()
+
+   local xs, ys = ffi.new('double[?]', n+1), ffi.new('double[?]', n+1)
+   for i = 0, n do xs[i] = x0 + i * (x1 - x0) / n end
+   xs[n] = x1
+   if f_many then
+      f_many(xs, ys, n+1)
+   else
+      for i = 0, n do ys[i] = f(xs[i]) end
+   end
+
+   -- each bracket is stored as xa, fa, xb, fb and the tolerance on f
+   local brackets = ffi.new('double[?]', 5*n)
+   local nb = 0
+   for i = 0, n do
+      local fi = ys[i]
+      if fi == 0 then
+	 solver_add_root(s, xs[i])
+      elseif i < n and fi * ys[i+1] < 0 then
+	 local b = brackets + 5*nb
+	 b[0], b[1], b[2], b[3] = xs[i], fi, xs[i+1], ys[i+1]
+	 b[4] = s.scale_f and s.eps * s.scale_f((xs[i]+xs[i+1])/2) or s.eps
+	 nb = nb + 1
+      elseif i > 0 and i < n and fi * ys[i-1] > 0 and fi * ys[i+1] > 0
+	 and abs(fi) < abs(ys[i-1]) and abs(fi) < abs(ys[i+1]) then
+	 interval_roots(s, xs[i-1], ys[i-1], xs[i+1], ys[i+1])
+      end
+   end
+
+   if nb > 0 then
+      local rs = ffi.new('double[?]', nb)
+      if s.use_parallel then
+         local parallel = require 'parallel'
+         parallel.brent(f, brackets, rs, nb, s.del)
+      else
+         for j = 0, nb-1 do
+            local b = brackets + 5*j
+            rs[j] = brent(f, b[0], b[1], b[2], b[3], b[4], s.del)
+         end
+      end
+      for j = 0, nb-1 do solver_add_root(s, rs[j]) end
+   end
+
+   -- the roots are sorted and the ones found twice, within the
+   -- tolerance, are removed
+   local rs = s.roots
+   table.sort(rs)
+   local k = 0
+   for j = 1, #rs do
+      if k == 0 or rs[j] - rs[k] > s.del then
+	 k = k + 1
+	 rs[k] = rs[j]
+      end
+   end
+   for j = #rs, k+1, -1 do rs[j] = nil end
+   return rs
+end
+
 local function root_solver_new (f, eps, del, scale_f)
    return {f= f, eps= eps, del= del,
 	   scale_f = scale_f,
 	   tolerance = solver_tolerance,
+	   parallel = solver_parallel,
 	   root = solver_root,
-	   solve = solver_interval_solve
+	   solve = solver_interval_solve,
+	   solve_grid = solver_grid_solve,
 	}
 end
 
-return {solver = root_solver_new}
+return {solver = root_solver_new, brent = brent}
@@ -0,0 +1,42 @@
+-- lua-bundle.lua
+--
+-- Generate the C header with the bytecode of the given Lua modules
+-- to be embedded in the GSL Shell executable.
+--
+-- Usage: luajit lua-bundle.lua <output> <file.lua>...
+--
+-- The module name is the file name without the ".lua" extension so
+-- that "help/graphics.lua" is registered as "help/graphics".
+
+local output = assert(arg[1], "missing output file name")
+
+local out = {}
+local function add(s) out[#out+1] = s end
+
+add("/* Generated by scripts/lua-bundle.lua. Do not edit. */\n\n")
+
+local names = {}
+for k = 2, #arg do
+   local filename = arg[k]
+   local name = filename:gsub("%.lua$", "")
+   local f = assert(loadfile(filename))
+   local bc = string.dump(f)
+
+   add(string.format("static const unsigned char bundle_bc%i[] = {", k - 1))
+   for i = 1, #bc do
+      if (i - 1) % 16 == 0 then add("\n   ") end
+      add(string.format("%i,", bc:byte(i)))
+   end
+   add("\n};\n\n")
+   names[#names+1] = name
+end
+
+add("static const struct bundle_entry bundle_entries[] = {\n")
+for k, name in ipairs(names) do
+   add(string.format("   {%q, bundle_bc%i, sizeof(bundle_bc%i)},\n", name, k, k))
+end
+add("   {NULL, NULL, 0}\n};\n")
+
+local f = assert(io.open(output, "w"))
+f:write(table.concat(out))
+f:close()
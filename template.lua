@@ -3,6 +3,8 @@
 -- Adapted by Steve Donovan, based on original code of Rici Lake.
 --
 
+local bit = require 'bit'
+
 local M = {}
 
 -------------------------------------------------------------------------------
@@ -66,6 +68,56 @@ local function preprocess(chunk, name, defs)
    end
 end
 
+-- Cache of the compiled templates. The key is the template name and a
+-- canonical serialisation of "defs". In memory the compiled chunk is
+-- stored and it is run at each call of template.load so that a new
+-- instance is always returned. If a cache directory is given, with
+-- template.cache_dir or the environment variable
+-- GSL_SHELL_TEMPLATE_CACHE, the generated code is also stored on disk
+-- together with a checksum of each template file it depends on.
+
+local chunk_cache = {}
+local cache_dir = os.getenv('GSL_SHELL_TEMPLATE_CACHE')
+
+-- when not nil the template files read by "process" are recorded
+local deps_record
+
+-- FNV-1a hash of a string, returned as a hexadecimal string
+local function checksum(s)
+   local bxor, tobit, lshift = bit.bxor, bit.tobit, bit.lshift
+   local h = tobit(2166136261)
+   for i = 1, #s do
+      h = bxor(h, s:byte(i))
+      -- multiply by the FNV prime 2^24 + 403 modulo 2^32
+      h = tobit(lshift(h, 24) + h * 403)
+   end
+   return bit.tohex(h)
+end
+
+-- return a string that uniquely identifies the definitions or nil if
+-- they contain values other than numbers, strings or booleans
+local function canonical_defs(defs)
+   local keys = {}
+   for k, v in pairs(defs) do
+      local tv = type(v)
+      if type(k) ~= 'string' or (tv ~= 'number' and tv ~= 'string' and tv ~= 'boolean') then
+         return nil
+      end
+      keys[#keys+1] = k
+   end
+   table.sort(keys)
+   local ls = {}
+   for i, k in ipairs(keys) do
+      local v = defs[k]
+      if type(v) == 'number' then
+         ls[i] = string.format('%s=%.17g', k, v)
+      else
+         ls[i] = string.format('%s=%s:%q', k, type(v), tostring(v))
+      end
+   end
+   return table.concat(ls, ',')
+end
+
 local function read_file(filename)
    local f = io.open(filename)
    if not f then 
@@ -76,10 +128,73 @@ local function read_file(filename)
    return content
 end
 
+local function cache_filename(name, key)
+   return string.format('%s/%s-%s.lua', cache_dir, name, checksum(key))
+end
+
+-- return the code stored on disk if it was generated with the same
+-- definitions and the template files did not change since then
+local function disk_lookup(name, key)
+   local f = io.open(cache_filename(name, key))
+   if not f then return end
+   local content = f:read('*a')
+   f:close()
+
+   local s = 1
+   local defs_line
+   while true do
+      local e, line = select(2, content:find('^%-%- ([^\n]*)\n', s))
+      if not e then break end
+      s = e + 1
+      if not defs_line then
+         defs_line = line
+         if defs_line ~= 'defs ' .. key then return end
+      else
+         local hash, dep = line:match('^depends (%x+) (.*)$')
+         if not hash then break end
+         local df = io.open(dep)
+         if not df then return end
+         local dep_content = df:read('*a')
+         df:close()
+         if checksum(dep_content) ~= hash then return end
+      end
+   end
+   if defs_line then return content end
+end
+
+-- The code is written in a temporary file renamed when complete so
+-- that another process never reads a partially written file. The name
+-- of the temporary file is made unique among the processes using the
+-- name of a file reserved by os.tmpname, kept until the end.
+local function disk_store(name, key, code, deps)
+   local filename = cache_filename(name, key)
+   local ok_tmp, reserved = pcall(os.tmpname)
+   if not ok_tmp then return end
+   local tmpname = string.format('%s.%s-%d.tmp', filename,
+                                 reserved:match('[^/\\]*$'), os.time())
+   local f = io.open(tmpname, 'w')
+   -- the cache directory may not be writable, the cache is optional
+   if not f then
+      os.remove(reserved)
+      return
+   end
+   f:write('-- defs ', key, '\n')
+   for _, dep in ipairs(deps) do
+      f:write('-- depends ', dep[2], ' ', dep[1], '\n')
+   end
+   local ok = f:write(code)
+   f:close()
+   if not (ok and os.rename(tmpname, filename)) then os.remove(tmpname) end
+   os.remove(reserved)
+end
+
 local function process(name, defs)
    local filename, errmsg = package.searchpath(name, package.path)
    if not filename then error(errmsg) end
    local template = read_file(filename)
+   if deps_record then
+      deps_record[#deps_record+1] = {filename, checksum(template)}
+   end
    local codegen = preprocess(template, 'template_gen', defs)
    local code = {}
    local add = function(s) code[#code+1] = s end
@@ -95,15 +210,48 @@ local function template_error(code, filename, err)
    error('error loading ' .. filename .. ':' .. err)
 end
 
+-- generate the code and, if the disk cache is enabled, store it. The
+-- second value returned is true if the code was read from the cache.
+-- If "refresh" is true the cached code is ignored and replaced.
+local function generate(name, defs, key, refresh)
+   if not (key and cache_dir) then return process(name, defs) end
+   local code = not refresh and disk_lookup(name, key)
+   if code then return code, true end
+   deps_record = {}
+   local ok, result = pcall(process, name, defs)
+   local deps = deps_record
+   deps_record = nil
+   if not ok then error(result, 0) end
+   disk_store(name, key, result, deps)
+   return result
+end
+
 local function load(filename, defs)
-   local code = process(filename, defs)
-   local f, err = loadstring(code, filename)
-   if not f then template_error(code, filename, err) end
+   local key = canonical_defs(defs)
+   local id = key and (filename .. '|' .. key)
+   local f = id and chunk_cache[id]
+   if not f then
+      local code, cached = generate(filename, defs, key)
+      local err
+      f, err = loadstring(code, filename)
+      if not f and cached then
+         -- the cached file is corrupted, generate the code again
+         code = generate(filename, defs, key, true)
+         f, err = loadstring(code, filename)
+      end
+      if not f then template_error(code, filename, err) end
+      if id then chunk_cache[id] = f end
+   end
    return f()
 end
 
+local function set_cache_dir(dirname)
+   if dirname ~= nil then cache_dir = dirname or nil end
+   return cache_dir
+end
+
 M.process = process
 M.load = load
+M.cache_dir = set_cache_dir
 
 return M
-
@@ -0,0 +1,33 @@
+--Test file for the banded B-spline fit, the results should be the
+--same of num.linfit with the dense model matrix
+local function max_diff(a, b)
+   local n1, n2 = matrix.dim(a)
+   local d = 0
+   for i = 1, n1 do
+      for j = 1, n2 do
+         d = math.max(d, math.abs(a:get(i, j) - b:get(i, j)))
+      end
+   end
+   return d
+end
+
+local n = 40
+local x = matrix.new(n, 1, |i| 10 * (i - 1) / (n - 1))
+local y = matrix.new(n, 1, |i| math.sin(x[i]) + 0.1 * math.cos(7 * x[i]))
+local w = matrix.new(n, 1, |i| 1 + (i % 3))
+
+local bs = num.bspline(0, 10, 6)
+local X = bs:model(x)
+local B = bs:model_band(x)
+
+local c, chisq, cov = num.linfit(X, y)
+local cb, chisqb, covb = B:linfit(y)
+print("Unweighted coefficients: ", max_diff(c, cb))
+print("Unweighted chi square: ", math.abs(chisq - chisqb))
+print("Unweighted covariance: ", max_diff(cov, covb))
+
+local c, chisq, cov = num.linfit(X, y, w)
+local cb, chisqb, covb = B:linfit(y, w)
+print("Weighted coefficients: ", max_diff(c, cb))
+print("Weighted chi square: ", math.abs(chisq - chisqb))
+print("Weighted covariance: ", max_diff(cov, covb))
@@ -14,3 +14,41 @@ print("Generalized Symmetric ", eigen.gensymm(a,a, eigen.SORT_ABS_ASC))
 --print("Generalized Hermitian ", eigen.genherm(b,b, eigen.SORT_ABS_ASC))
 
 print("General Non-Symmetric ", eigen.genv(a,a, eigen.SORT_ABS_ASC))
+
+-- eigen.symm_many should give the same results as eigen.symm for each
+-- matrix of the stack, also when the rows of the stack are not
+-- contiguous
+local function symm_many_check(stack, n, order)
+   local evals, evecs = eigen.symm_many(stack, n, order)
+   local k = stack:dim() / n
+   local diff = 0
+   for j = 0, k - 1 do
+      local e, v = eigen.symm(stack:slice(j*n + 1, 1, n, n), order)
+      for i = 1, n do
+         diff = math.max(diff, math.abs(evals:get(j + 1, i) - e[i]))
+         for l = 1, n do
+            diff = math.max(diff, math.abs(evecs:get(j*n + i, l) - v:get(i, l)))
+         end
+      end
+   end
+   return diff
+end
+
+local n, k = 4, 5
+local r = rng.new()
+local big = matrix.new(k * n, n + 2)
+for j = 0, k - 1 do
+   for i = 1, n do
+      for l = i, n do
+         local x = r:get()
+         big:set(j*n + i, l + 1, x)
+         big:set(j*n + l, i + 1, x)
+      end
+   end
+end
+local contiguous = big:slice(1, 2, k * n, n):copy()
+local strided = big:slice(1, 2, k * n, n)
+
+print("Symmetric many, contiguous ", symm_many_check(contiguous, n, 'asc'))
+print("Symmetric many, strided ", symm_many_check(strided, n, 'asc'))
+print("Symmetric many, unsorted ", symm_many_check(strided, n, 'none'))
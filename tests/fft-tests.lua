@@ -164,9 +164,39 @@ local function test1_stride()
    end
 end
 
+-- num.fft_many should give the same coefficients as num.fft applied to
+-- each column, or to each row, also when the input matrix is a view
+-- with a larger row stride
+local function test_many()
+   local n, nb = 8*3*5, 3
+   local big = matrix.new(n, nb + 2, |i, j| sin(i * j / 7) + (i % (j + 2)))
+   local m = big:slice(1, 2, n, nb)
+
+   local function maxdiff(fts, get_column)
+      local diff = 0
+      for j, ft in ipairs(fts) do
+         local ftref = fft(get_column(j))
+         for k = 0, n - 1 do
+            diff = max(diff, complex.abs(ft:get(k) - ftref:get(k)))
+         end
+      end
+      return diff
+   end
+
+   local bigt = matrix.new(nb, n + 2, |i, j| (j > 1 and j <= n + 1) and m:get(j - 1, i) or 0)
+   local mt = bigt:slice(1, 2, nb, n)
+
+   local dcol = maxdiff(num.fft_many(m), |j| m:col(j))
+   local dcopy = maxdiff(num.fft_many(m:copy()), |j| m:col(j))
+   local drow = maxdiff(num.fft_many(mt, 2), |j| m:col(j))
+   print('fft_many columns', dcol, 'contiguous', dcopy, 'rows', drow)
+   return dcol, dcopy, drow
+end
+
 return {test1= test1, 
 	test2= test1_radix2, 
 	test3= test1_ip_radix2, 
 	test4= test1_ip, 
 	test5= test2, 
-	test6= test1_stride}
+	test6= test1_stride,
+	test7= test_many}